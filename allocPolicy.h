@@ -0,0 +1,171 @@
+/*
+ * Alex Li
+ * allocPolicy header
+ *
+ * Allocator policies for HashMap links. A policy is a default constructible type that
+ * creates and frees links and decides where key bytes are kept. releasesAll tells the map
+ * whether the policy frees every link at once when it is destroyed, in which case links
+ * with trivial destructors are not walked one by one. allocAdopt() hands the links of one
+ * policy object to another, which lets threads build links with allocators of their own.
+ */
+
+#pragma once
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#define ARENA_BLOCK_BYTES 65536 // default size of an arena block
+
+/*
+ * Allocates every link with its own new and frees it with delete. Keys are stored as given
+ */
+struct HeapAllocator {
+	static const bool releasesAll = false;
+
+	template <typename Link, typename... Args>
+	Link* allocLink(Args &&...args) { return new Link(std::forward<Args>(args)...); }
+
+	template <typename Link>
+	void freeLink(Link *link) { delete link; }
+
+	template <typename K>
+	K&& storeKey(K &&key) { return std::forward<K>(key); }
+
+	/*
+	 * Takes over the links of another allocator; links from new need no owner, so nothing moves
+	 * @param other allocator
+	 */
+	void allocAdopt(HeapAllocator &) {}
+
+	/*
+	 * Returns the bytes held for links and keys beyond the links themselves
+	 * @return arena bytes, always 0
+	 */
+	size_t allocBytes() const { return 0; }
+};
+
+/*
+ * Bump allocator: links are carved out of large blocks in allocation order, so a chain
+ * walk touches few pages, and all blocks are freed together when the map is destroyed.
+ * Freed links go on a free list and are reused by later allocations. Keys are stored as
+ * given; a std::string key still owns its own buffer when it is too long for the small
+ * string buffer
+ */
+class ArenaAllocator {
+public:
+	static const bool releasesAll = true;
+
+	ArenaAllocator() : mNext(nullptr), mEnd(nullptr), mFree(nullptr), mBytes(0) {}
+
+	/*
+	 * ArenaAllocator destructor, frees every block at once. Links must already be destroyed
+	 * if their destructors are not trivial
+	 */
+	~ArenaAllocator() {
+		for (size_t i = 0; i < mBlocks.size(); i++)
+			free(mBlocks[i]);
+	}
+
+	ArenaAllocator(const ArenaAllocator &) = delete;
+	ArenaAllocator &operator=(const ArenaAllocator &) = delete;
+
+	template <typename Link, typename... Args>
+	Link* allocLink(Args &&...args) {
+		void *memory;
+		if (mFree) {
+			memory = mFree;
+			mFree = *(void **)mFree;
+		}
+		else
+			memory = arenaAlloc(sizeof(Link) < sizeof(void *) ? sizeof(void *) : sizeof(Link), alignof(Link));
+
+		return new (memory) Link(std::forward<Args>(args)...);
+	}
+
+	/*
+	 * Destroys the link and keeps its memory on the free list
+	 * @param link
+	 */
+	template <typename Link>
+	void freeLink(Link *link) {
+		link->~Link();
+		*(void **)link = mFree;
+		mFree = link;
+	}
+
+	template <typename K>
+	K&& storeKey(K &&key) { return std::forward<K>(key); }
+
+	/*
+	 * Takes over every block of another arena, so links and keys carved from it are freed
+	 * with this one. The other arena is left empty; its free list is dropped
+	 * @param other arena
+	 */
+	void allocAdopt(ArenaAllocator &other) {
+		mBlocks.insert(mBlocks.end(), other.mBlocks.begin(), other.mBlocks.end());
+		mBytes += other.mBytes;
+		other.mBlocks.clear();
+		other.mNext = nullptr;
+		other.mEnd = nullptr;
+		other.mFree = nullptr;
+		other.mBytes = 0;
+	}
+
+	/*
+	 * Returns the bytes held by all blocks
+	 * @return arena bytes
+	 */
+	size_t allocBytes() const { return mBytes; }
+
+protected:
+	/*
+	 * Returns bytes from the current block, starting a new block when it is full. Requests
+	 * larger than a block get a block of their own
+	 * @param number of bytes, alignment
+	 * @return pointer to uninitialized memory
+	 */
+	void* arenaAlloc(size_t bytes, size_t alignment) {
+		char *start = (char *)(((size_t)mNext + alignment - 1) & ~(alignment - 1));
+		if (!mNext || start + bytes > mEnd) {
+			size_t blockBytes = bytes + alignment > ARENA_BLOCK_BYTES ? bytes + alignment : ARENA_BLOCK_BYTES;
+			char *block = (char *)malloc(blockBytes);
+			if (!block)
+				throw std::bad_alloc();
+
+			mBlocks.push_back(block);
+			mBytes += blockBytes;
+			mNext = block;
+			mEnd = block + blockBytes;
+			start = (char *)(((size_t)mNext + alignment - 1) & ~(alignment - 1));
+		}
+
+		mNext = start + bytes;
+		return start;
+	}
+
+private:
+	std::vector<char *> mBlocks;
+	char *mNext; // first free byte of the current block
+	char *mEnd; // end of the current block
+	void *mFree; // freed links, linked through their first word
+	size_t mBytes; // bytes in all blocks
+};
+
+/*
+ * ArenaAllocator that also copies string_view keys into the arena, next to the links, so a
+ * map of string_view keys owns its keys and needs no storage of its own for them. Key bytes
+ * are not reused when their link is removed
+ */
+class ArenaKeyAllocator : public ArenaAllocator {
+public:
+	using ArenaAllocator::storeKey;
+
+	std::string_view storeKey(std::string_view key) {
+		char *bytes = (char *)arenaAlloc(key.length(), 1);
+		memcpy(bytes, key.data(), key.length());
+		return std::string_view(bytes, key.length());
+	}
+};
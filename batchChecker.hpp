@@ -0,0 +1,108 @@
+/*
+ * Alex Li
+ * batchChecker header
+ */
+
+#pragma once
+#include "documentChecker.hpp"
+#include "workStealingPool.hpp"
+#include <algorithm>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using std::string;
+using std::string_view;
+
+#define BATCH_LOOKUP_CHUNK 1024 // words per lookup task
+#define BATCH_READ_BLOCK (1 << 20) // bytes read from the document at a time
+
+// verdict for one word of a batch
+struct BatchResult {
+	bool correct;
+	vector<string> suggestions; // empty for correct words
+};
+
+/*
+ * Checks a batch of words on a work stealing pool. Lookups run as one task per
+ * BATCH_LOOKUP_CHUNK words, and every miss a lookup task finds is queued as its own
+ * suggestion task. Suggestion searches cost far more than lookups and vary a lot from word
+ * to word, so splitting them out lets idle workers steal them instead of waiting on the
+ * worker that happened to get a chunk full of misspellings. Each task writes only its own
+ * slots of results, so results[i] belongs to words[i] however the tasks were scheduled.
+ * Searches run serially inside their task; options->pool is not used
+ * @param words to check, ptr to loaded dictionary, suggestion options, pool, output results
+ */
+inline void checkBatch(std::span<const string_view> words, Dictionary *dictionary, SuggestOptions *options, WorkStealingPool *pool, vector<BatchResult> &results) {
+	results.assign(words.size(), BatchResult());
+
+	// the batch is already parallel, so each search stays on its task's thread
+	SuggestOptions serial = *options;
+	serial.pool = nullptr;
+
+	for (size_t first = 0; first < words.size(); first += BATCH_LOOKUP_CHUNK) {
+		size_t last = std::min(first + BATCH_LOOKUP_CHUNK, words.size());
+		pool->poolSubmit([=, &results, &serial] {
+			string word;
+			for (size_t i = first; i < last; i++) {
+				lowercaseWord(words[i], word);
+				results[i].correct = dictionary->mapContains(word);
+				if (results[i].correct)
+					continue;
+
+				pool->poolSubmit([=, &results, &serial] {
+					string misspelled;
+					lowercaseWord(words[i], misspelled);
+					collectSuggestions(dictionary, &serial, misspelled, results[i].suggestions);
+				});
+			}
+		});
+	}
+
+	pool->poolWait();
+}
+
+/*
+ * Checks a whole document with checkBatch. The document is read into memory once and split
+ * into words in place, the batch is checked on the pool, and the misspellings are written
+ * in document order in the same format as checkDocument
+ * @param input stream, output stream, ptr to loaded dictionary, suggestion options and pool
+ * @return word and misspelling counts
+ */
+inline CheckStats checkDocumentBatch(std::istream &in, std::ostream &out, Dictionary *dictionary, SuggestOptions *options, WorkStealingPool *pool) {
+	string text;
+	size_t used = 0;
+	while (in) {
+		text.resize(used + BATCH_READ_BLOCK);
+		in.read(&text[used], BATCH_READ_BLOCK);
+		used += (size_t)in.gcount();
+	}
+	text.resize(used);
+
+	// the tokens are views into text, which outlives the batch
+	Tokenizer tokenizer(text);
+	vector<string_view> words;
+	vector<unsigned long long> offsets;
+	string_view token;
+	unsigned long long offset;
+	while (tokenizer.next(token, offset)) {
+		words.push_back(token);
+		offsets.push_back(offset);
+	}
+
+	vector<BatchResult> results;
+	checkBatch(words, dictionary, options, pool, results);
+
+	CheckStats stats = { words.size(), 0 };
+	BufferedWriter writer(out);
+	for (size_t i = 0; i < results.size(); i++) {
+		if (results[i].correct)
+			continue;
+
+		stats.misspellings++;
+		writeMisspelling(writer, offsets[i], words[i], results[i].suggestions);
+	}
+
+	return stats;
+}
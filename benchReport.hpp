@@ -0,0 +1,146 @@
+/*
+ * Alex Li
+ * benchReport header
+ */
+
+#pragma once
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+// one measurement of a benchmark run
+struct BenchResult {
+	string suite; // group of benchmarks, such as lookup or distance
+	string name; // what was measured, such as a map or kernel label
+	string metric; // such as contains_hit or p99
+	double value;
+	string unit; // such as ns/op or s
+};
+
+/*
+ * Collects measurements of a benchmark run and writes them as CSV or JSON, so results can
+ * be compared across builds. Every row carries its unit; rows keep the order they were
+ * recorded in
+ */
+class BenchReport {
+public:
+	/*
+	 * Records one measurement
+	 * @param suite, name, metric, value, unit
+	 */
+	void reportAdd(const string &suite, const string &name, const string &metric, double value, const string &unit) {
+		BenchResult result = { suite, name, metric, value, unit };
+		mResults.push_back(result);
+	}
+
+	/*
+	 * Records a property of the whole run, such as the seed, written with every report
+	 * @param key, value
+	 */
+	void reportSetting(const string &key, const string &value) { mSettings.push_back(std::make_pair(key, value)); }
+
+	/*
+	 * Writes the measurements as CSV with a header row, settings first as comment lines
+	 * Returns 0 on success and -1 otherwise
+	 * @param file name
+	 * @return int indicating whether the file was written
+	 */
+	int reportWriteCsv(const string &fname) const {
+		std::ofstream out(fname);
+		if (!out)
+			return -1;
+
+		for (size_t i = 0; i < mSettings.size(); i++)
+			out << "# " << mSettings[i].first << "=" << mSettings[i].second << "\n";
+
+		out << "suite,name,metric,value,unit\n";
+		for (size_t i = 0; i < mResults.size(); i++) {
+			const BenchResult &r = mResults[i];
+			out << csvField(r.suite) << "," << csvField(r.name) << "," << csvField(r.metric) << "," << r.value << "," << csvField(r.unit) << "\n";
+		}
+
+		return out ? 0 : -1;
+	}
+
+	/*
+	 * Writes the measurements as one JSON object with the settings and a results array. A
+	 * value that is not finite, such as a speedup over a zero time, is written as null
+	 * Returns 0 on success and -1 otherwise
+	 * @param file name
+	 * @return int indicating whether the file was written
+	 */
+	int reportWriteJson(const string &fname) const {
+		std::ofstream out(fname);
+		if (!out)
+			return -1;
+
+		out << "{\n  \"settings\": {";
+		for (size_t i = 0; i < mSettings.size(); i++)
+			out << (i ? ", " : "") << jsonString(mSettings[i].first) << ": " << jsonString(mSettings[i].second);
+		out << "},\n  \"results\": [\n";
+
+		for (size_t i = 0; i < mResults.size(); i++) {
+			const BenchResult &r = mResults[i];
+			out << "    {\"suite\": " << jsonString(r.suite) << ", \"name\": " << jsonString(r.name) << ", \"metric\": " << jsonString(r.metric);
+			out << ", \"value\": ";
+			if (std::isfinite(r.value))
+				out << r.value;
+			else
+				out << "null";
+			out << ", \"unit\": " << jsonString(r.unit) << "}" << (i + 1 < mResults.size() ? "," : "") << "\n";
+		}
+		out << "  ]\n}\n";
+
+		return out ? 0 : -1;
+	}
+
+private:
+	/*
+	 * Quotes a CSV field when it holds a comma, quote or newline
+	 * @param field
+	 * @return field as written
+	 */
+	static string csvField(const string &field) {
+		if (field.find_first_of(",\"\n") == string::npos)
+			return field;
+
+		string quoted = "\"";
+		for (size_t i = 0; i < field.length(); i++) {
+			if (field[i] == '"')
+				quoted += '"';
+			quoted += field[i];
+		}
+		return quoted + "\"";
+	}
+
+	/*
+	 * Returns a JSON string literal, escaping quotes, backslashes and control characters
+	 * @param text
+	 * @return quoted text
+	 */
+	static string jsonString(const string &text) {
+		string quoted = "\"";
+		for (size_t i = 0; i < text.length(); i++) {
+			if (text[i] == '"' || text[i] == '\\')
+				quoted += '\\';
+
+			if ((unsigned char)text[i] < 0x20) {
+				char escape[8];
+				snprintf(escape, sizeof(escape), "\\u%04x", text[i]);
+				quoted += escape;
+			}
+			else
+				quoted += text[i];
+		}
+		return quoted + "\"";
+	}
+
+	vector<BenchResult> mResults;
+	vector<std::pair<string, string> > mSettings;
+};
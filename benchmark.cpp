@@ -0,0 +1,1229 @@
+/*
+ * Alex Li
+ * benchmark implementation
+ */
+
+#include "hashMap.hpp"
+#include "flatHashMap.hpp"
+#include "swissHashMap.hpp"
+#include "concurrentHashMap.hpp"
+#include "suggestions.hpp"
+#include "batchChecker.hpp"
+#include "processMemory.hpp"
+#include "benchReport.hpp"
+#include "misspellingGenerator.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <malloc.h>
+#include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <new>
+#include <random>
+#include <thread>
+#include <vector>
+
+#define BENCH_BATCH_WORDS 200000 // words in the checkBatch corpus
+#define BENCH_BATCH_MISS_RATE 50 // one misspelling per this many corpus words
+#define BENCH_LONG_TOKEN 3000 // letters of the oversized token checked in every suggestion mode
+#define BENCH_CONCURRENT_READERS 4 // reader threads in the concurrent map runs
+#define BENCH_CONCURRENT_WRITERS 2 // writer threads in the concurrent map runs
+#define BENCH_CONCURRENT_ROUNDS 3 // insert/remove rounds per writer
+#define BENCH_IMAGE_FILE "benchmark.img" // scratch dictionary image, removed afterwards
+#define BENCH_RESIZE_STEP 16 // old buckets moved per operation by the incremental resize runs
+#define BENCH_SEED 20240601 // default seed of the misspelling generator, see --seed
+#define BENCH_LATENCY_QUERIES 200 // generated misspellings timed one by one per suggestion mode
+#define BENCH_DISTANCE_PAIRS 20000 // generated (misspelling, word) pairs per word length class
+#define BENCH_FILTER_RUNS 3 // timed passes per filter size, the fastest is kept
+#define BENCH_CACHE_QUERIES 5000 // misspellings checked per suggestion cache size, drawn with recurrence
+
+using std::ifstream;
+using std::vector;
+
+typedef std::chrono::steady_clock benchClock;
+
+// every measurement of the run, written out by --json and --csv
+static BenchReport report;
+
+// word length classes of the distance kernel runs, by dictionary word length
+struct LengthClass {
+	const char *name;
+	size_t shortest;
+	size_t longest;
+};
+static const LengthClass lengthClasses[] = { { "1-4", 1, 4 }, { "5-8", 5, 8 }, { "9-12", 9, 12 }, { "13+", 13, (size_t)-1 } };
+
+// heap allocations made by the whole process, counted by the replaced operator new below
+static std::atomic<long long> heapAllocations(0);
+
+/*
+ * Counts and makes one heap allocation for the replaced operator new forms
+ * @param bytes
+ * @return memory
+ */
+static void* countedAlloc(size_t bytes) {
+	heapAllocations++;
+	void *memory = malloc(bytes ? bytes : 1);
+	if (!memory)
+		throw std::bad_alloc();
+	return memory;
+}
+
+/*
+ * Frees memory of countedAlloc for the replaced operator delete forms
+ * @param memory
+ */
+static void countedFree(void *memory) noexcept { free(memory); }
+
+void* operator new(size_t bytes) { return countedAlloc(bytes); }
+void* operator new[](size_t bytes) { return countedAlloc(bytes); }
+void operator delete(void *memory) noexcept { countedFree(memory); }
+void operator delete(void *memory, size_t) noexcept { countedFree(memory); }
+void operator delete[](void *memory) noexcept { countedFree(memory); }
+void operator delete[](void *memory, size_t) noexcept { countedFree(memory); }
+
+/*
+ * HashMap behind a single mutex, the baseline for ConcurrentHashMap
+ */
+class LockedHashMap {
+public:
+	LockedHashMap(int capacity) : mMap(capacity) {}
+
+	bool mapContains(const string &key) {
+		std::lock_guard<std::mutex> lock(mMutex);
+		return mMap.mapContains(key);
+	}
+
+	void mapPut(const string &key, int value) {
+		std::lock_guard<std::mutex> lock(mMutex);
+		mMap.mapPut(key, value);
+	}
+
+	bool mapRemove(const string &key) {
+		std::lock_guard<std::mutex> lock(mMutex);
+		return mMap.mapRemove(key);
+	}
+
+	int mapSize() const { return mMap.mapSize(); }
+
+private:
+	HashMap<string, int> mMap;
+	std::mutex mMutex;
+};
+
+// prototypes
+int readWords(string fname, vector<string> &words);
+double elapsedSeconds(benchClock::time_point start);
+void benchLoad(const string &fname, Dictionary &dictionary, MappedFile &file);
+void benchImage(Dictionary *dictionary, SuggestOptions *options, const vector<string> &queries);
+template <typename Map> void benchAllocator(const string &name, const vector<string> &words);
+void benchResize(const string &name, int step, const vector<string> &words);
+void benchBulkLoad(const vector<string> &words);
+void benchPerfect(const vector<string> &words, const vector<string> &misses);
+void benchFilter(const vector<string> &words, const vector<string> &misses);
+void benchParallelLoad(const string &fname, const vector<string> &words);
+bool sameChains(const Dictionary &first, const Dictionary &second);
+void benchAllocations(HashMap<string, int> &map, Dictionary *dictionary, SuggestOptions *options, const vector<string> &words, const vector<string> &queries);
+template <typename Map> void benchLookup(const string &name, Map &map, const vector<string> &words, const vector<string> &misses);
+template <typename Hash> void benchChains(const string &name, const vector<string> &words);
+void benchDistance(const string &name, DistanceFunction distance, const vector<string> &words, const vector<string> &queries);
+void benchDistanceClasses(const string &name, DistanceFunction distance, const vector<string> &words, unsigned int seed);
+void benchLatency(const string &name, Dictionary *dictionary, SuggestOptions *options, const vector<string> &queries, const vector<string> &sources);
+void benchSuggest(const string &name, Dictionary *dictionary, SuggestOptions *options, const vector<string> &queries);
+void benchCache(Dictionary *dictionary, SuggestOptions *options, const vector<string> &misspellings, unsigned int seed);
+size_t dictionaryBytes(HashMap<string, int> &map);
+void benchThreads(Dictionary *dictionary, SuggestOptions *options, const vector<string> &queries);
+void benchBatch(Dictionary *dictionary, SuggestOptions *options, const vector<string> &words, const vector<string> &queries);
+void stressConcurrent(const vector<string> &words);
+template <typename Map> void benchConcurrent(const string &name, const vector<string> &words);
+
+int main(int argc, char *argv[]) {
+	string jsonName = ""; // file for JSON results, empty for none
+	string csvName = ""; // file for CSV results, empty for none
+	unsigned int seed = BENCH_SEED;
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if (arg.compare(0, 7, "--json=") == 0)
+			jsonName = arg.substr(7);
+		else if (arg.compare(0, 6, "--csv=") == 0)
+			csvName = arg.substr(6);
+		else if (arg.compare(0, 7, "--seed=") == 0)
+			seed = (unsigned int)strtoul(arg.c_str() + 7, nullptr, 10);
+		else {
+			cout << "Usage: " << argv[0] << " [--json=file] [--csv=file] [--seed=n]" << endl;
+			return 1;
+		}
+	}
+
+	vector<string> words;
+	if (readWords("dictionary.txt", words) == -1) {
+		cout << "Failed to load dictionary file!" << endl;
+		return 1;
+	}
+
+	cout << "Benchmarking " << words.size() << " dictionary words, misspelling seed " << seed << endl;
+	report.reportSetting("dictionary_words", std::to_string(words.size()));
+	report.reportSetting("seed", std::to_string(seed));
+
+	MappedFile dictionaryFile;
+	Dictionary dictionary(1000);
+	benchLoad("dictionary.txt", dictionary, dictionaryFile);
+
+	// one seeded misspelling per dictionary word as lookup misses, and a smaller set with
+	// the words they came from for suggestion latency
+	auto isWord = [&](const string &word) { return dictionary.mapContains(word); };
+	MisspellingGenerator generator(seed);
+	vector<string> misses, missSources, latencyQueries, latencySources;
+	generator.generate(words, (int)words.size(), SUGGESTION_MAX_DISTANCE, isWord, misses, missSources);
+	generator.generate(words, BENCH_LATENCY_QUERIES, SUGGESTION_MAX_DISTANCE, isWord, latencyQueries, latencySources);
+
+	benchAllocator<HashMap<string, int>>("HashMap<string> links from new", words);
+	benchAllocator<HashMap<string, int, WyHash, ArenaAllocator>>("HashMap<string> links from an arena", words);
+	benchAllocator<HashMap<string_view, int, WyHash, ArenaKeyAllocator>>("HashMap<string_view> links and keys from an arena", words);
+
+	benchResize("resize all at once", 0, words);
+	benchResize("incremental resize", 1, words);
+	benchResize("incremental resize", BENCH_RESIZE_STEP, words);
+	benchResize("incremental resize", BENCH_RESIZE_STEP * 16, words);
+	benchBulkLoad(words);
+	benchParallelLoad("dictionary.txt", words);
+
+	benchChains<HashFunction1>("HashFunction1", words);
+	benchChains<HashFunction2>("HashFunction2", words);
+	benchChains<FnvHash>("FnvHash", words);
+	benchChains<WyHash>("WyHash", words);
+
+	HashMap<string, int, HashFunction1> legacy(1000);
+	benchLookup("HashMap (chained, HashFunction1)", legacy, words, misses);
+
+	HashMap<string, int> chained(1000);
+	benchLookup("HashMap (chained, WyHash)", chained, words, misses);
+
+	FlatHashMap<string, int> flat(1000);
+	benchLookup("FlatHashMap (Robin Hood)", flat, words, misses);
+
+	SwissHashMap<string, int> swiss(1000);
+	benchLookup("SwissHashMap (group probing)", swiss, words, misses);
+
+	benchPerfect(words, misses);
+	benchFilter(words, misses);
+
+	stressConcurrent(words);
+	benchConcurrent<LockedHashMap>("HashMap behind a mutex", words);
+	benchConcurrent<ConcurrentHashMap<string, int>>("ConcurrentHashMap (sharded, epoch reads)", words);
+
+	// common misspellings, each scanned against the whole dictionary
+	const char *misspellings[] = { "teh", "helo", "wierd", "untill", "recieve", "seperate",
+		"begining", "occurence", "definately", "acommodate", "concious", "neccessary" };
+	vector<string> queries(misspellings, misspellings + sizeof(misspellings) / sizeof(misspellings[0]));
+
+	benchDistance("calcLD (matrix)", calcLD, words, queries);
+	benchDistance("calcLDMyers (bit-parallel)", calcLDMyers, words, queries);
+	benchDistance("calcLDSuggestion (banded, cutoff at 2)", calcLDSuggestion, words, queries);
+	benchDistanceClasses("calcLD (matrix)", calcLD, words, seed);
+	benchDistanceClasses("calcLDMyers (bit-parallel)", calcLDMyers, words, seed);
+	benchDistanceClasses("calcLDSuggestion (banded, cutoff at 2)", calcLDSuggestion, words, seed);
+
+	CandidateIndex partitions;
+	SymSpellIndex symSpell(SUGGESTION_MAX_DISTANCE);
+	BKTree bkTree(calcLDMyers);
+	Dawg dawg;
+
+	SuggestOptions options;
+	options.mode = SUGGEST_SCAN;
+	options.distance = calcLDSuggestion;
+	options.partitions = &partitions;
+	options.symSpell = &symSpell;
+	options.pool = nullptr;
+	options.cache = nullptr;
+	options.bkTree = &bkTree;
+	options.dawg = &dawg;
+
+	SuggestBuildTimes buildTimes;
+	buildSuggestionIndexes(&dictionary, &options, &buildTimes);
+	cout << "Suggestion indexes built: candidate index " << partitions.indexBytes() << " bytes in " << buildTimes.partitions;
+	cout << " s, SymSpell " << symSpell.indexEntries() << " entries in " << symSpell.indexBytes() << " bytes in " << buildTimes.symSpell << " s, BK-tree ";
+	cout << bkTree.treeBytes() << " bytes in " << buildTimes.bkTree << " s, DAWG " << dawg.dawgStates() << " states in " << dawg.dawgBytes() << " bytes in " << buildTimes.dawg << " s" << endl;
+	report.reportAdd("index", "CandidateIndex", "build", buildTimes.partitions, "s");
+	report.reportAdd("index", "SymSpellIndex", "build", buildTimes.symSpell, "s");
+	report.reportAdd("index", "BKTree", "build", buildTimes.bkTree, "s");
+	report.reportAdd("index", "Dawg", "build", buildTimes.dawg, "s");
+	cout << "  HashMap keys for comparison: " << dictionaryBytes(chained) << " bytes of links, strings and buckets" << endl;
+
+	benchImage(&dictionary, &options, queries);
+
+	benchAllocations(chained, &dictionary, &options, words, queries);
+	benchSuggest("suggestScan", &dictionary, &options, queries);
+
+	options.mode = SUGGEST_PARTITION;
+	benchSuggest("suggestPartitioned", &dictionary, &options, queries);
+
+	options.mode = SUGGEST_SYMSPELL;
+	benchSuggest("suggestSymSpell", &dictionary, &options, queries);
+
+	options.mode = SUGGEST_BKTREE;
+	benchSuggest("suggestBKTree", &dictionary, &options, queries);
+	cout << "  BK-tree visited " << bkTree.treeNodesVisited() / queries.size() << " of " << bkTree.treeSize() << " nodes per misspelling" << endl;
+
+	options.mode = SUGGEST_DAWG;
+	benchSuggest("suggestDawg", &dictionary, &options, queries);
+
+	cout << "Suggestion latency over " << latencyQueries.size() << " generated misspellings:" << endl;
+	const char *modeNames[] = { "suggestScan", "suggestPartitioned", "suggestSymSpell", "suggestBKTree", "suggestDawg" };
+	SuggestMode modes[] = { SUGGEST_SCAN, SUGGEST_PARTITION, SUGGEST_SYMSPELL, SUGGEST_BKTREE, SUGGEST_DAWG };
+	for (int m = 0; m < 5; m++) {
+		options.mode = modes[m];
+		benchLatency(modeNames[m], &dictionary, &options, latencyQueries, latencySources);
+	}
+
+	cout << "suggestPartitioned with a suggestion cache over " << BENCH_CACHE_QUERIES << " recurring misspellings:" << endl;
+	options.mode = SUGGEST_PARTITION;
+	benchCache(&dictionary, &options, latencyQueries, seed);
+
+	cout << "suggestScan on a thread pool (" << std::thread::hardware_concurrency() << " hardware threads):" << endl;
+	options.mode = SUGGEST_SCAN;
+	benchThreads(&dictionary, &options, queries);
+
+	cout << "checkBatch on a work stealing pool:" << endl;
+	options.mode = SUGGEST_PARTITION;
+	benchBatch(&dictionary, &options, words, queries);
+
+	if (!jsonName.empty() && report.reportWriteJson(jsonName) == -1) {
+		cout << "Failed to write " << jsonName << endl;
+		return 1;
+	}
+
+	if (!csvName.empty() && report.reportWriteCsv(csvName) == -1) {
+		cout << "Failed to write " << csvName << endl;
+		return 1;
+	}
+
+	return 0;
+}
+
+/********** function implementation **********/
+/*
+ * Reads every non-empty line of the dictionary file into words
+ * Returns 0 on success and -1 otherwise
+ * @param dictionary file name and output word list
+ * @return int indicating whether read was successful
+ */
+int readWords(string fname, vector<string> &words) {
+	string inputbuffer = "";
+	ifstream dictionaryFile(fname);
+	if (!dictionaryFile.is_open())
+		return -1;
+
+	while (getline(dictionaryFile, inputbuffer)) {
+		if (!inputbuffer.empty())
+			words.push_back(inputbuffer);
+	}
+	return 0;
+}
+
+/*
+ * Returns the seconds elapsed since start
+ * @param start time point
+ * @return elapsed seconds
+ */
+double elapsedSeconds(benchClock::time_point start) {
+	return std::chrono::duration<double>(benchClock::now() - start).count();
+}
+
+/*
+ * Loads every word into the map, then times a full pass of successful and failed
+ * mapContains lookups and of mapGet of every word. Prints load time and nanoseconds per lookup
+ * @param label, map under test, dictionary words and guaranteed misses
+ */
+template <typename Map>
+void benchLookup(const string &name, Map &map, const vector<string> &words, const vector<string> &misses) {
+	benchClock::time_point start = benchClock::now();
+	for (size_t i = 0; i < words.size(); i++)
+		map.mapPut(words[i], 1);
+	double loadTime = elapsedSeconds(start);
+
+	size_t found = 0;
+	start = benchClock::now();
+	for (size_t i = 0; i < words.size(); i++)
+		found += map.mapContains(words[i]);
+	double hitTime = elapsedSeconds(start);
+
+	start = benchClock::now();
+	for (size_t i = 0; i < misses.size(); i++)
+		found += map.mapContains(misses[i]);
+	double missTime = elapsedSeconds(start);
+
+	long long values = 0;
+	start = benchClock::now();
+	for (size_t i = 0; i < words.size(); i++)
+		values += *map.mapGet(words[i]);
+	double getTime = elapsedSeconds(start);
+
+	cout << name << ": " << map.mapSize() << " entries, " << map.mapCapacity() << " buckets" << endl;
+	cout << "  load:          " << loadTime << " s" << endl;
+	cout << "  contains hit:  " << hitTime * 1e9 / words.size() << " ns/op" << endl;
+	cout << "  contains miss: " << missTime * 1e9 / misses.size() << " ns/op" << endl;
+	cout << "  get:           " << getTime * 1e9 / words.size() << " ns/op" << endl;
+	if (found != words.size() || values != (long long)words.size())
+		cout << "  WARNING: " << found << " lookups succeeded, expected " << words.size() << endl;
+
+	report.reportAdd("lookup", name, "load", loadTime, "s");
+	report.reportAdd("lookup", name, "contains_hit", hitTime * 1e9 / words.size(), "ns/op");
+	report.reportAdd("lookup", name, "contains_miss", missTime * 1e9 / misses.size(), "ns/op");
+	report.reportAdd("lookup", name, "get", getTime * 1e9 / words.size(), "ns/op");
+}
+
+/*
+ * Loads every word into a chained HashMap using the given hash policy and prints the
+ * resulting chain length distribution
+ * @param policy label and dictionary words
+ */
+template <typename Hash>
+void benchChains(const string &name, const vector<string> &words) {
+	HashMap<string, int, Hash> map(1000);
+	for (size_t i = 0; i < words.size(); i++)
+		map.mapPut(words[i], 1);
+
+	vector<int> histogram = map.mapChainHistogram();
+	int used = map.mapCapacity() - map.mapEmptyBuckets();
+
+	cout << name << " chains: " << used << " of " << map.mapCapacity() << " buckets used, longest chain ";
+	cout << map.mapMaxChainLength() << ", average chain " << (double)map.mapSize() / used << endl;
+	cout << "  length:buckets";
+	for (size_t i = 0; i < histogram.size(); i++) {
+		if (histogram[i] != 0)
+			cout << " " << i << ":" << histogram[i];
+	}
+	cout << endl;
+}
+
+/*
+ * Computes the distance from every query word to every dictionary word and prints the
+ * time per distance. The distance checksum lets kernels be compared for agreement
+ * @param kernel label, distance kernel, dictionary words and query words
+ */
+void benchDistance(const string &name, DistanceFunction distance, const vector<string> &words, const vector<string> &queries) {
+	long long checksum = 0;
+	benchClock::time_point start = benchClock::now();
+	for (size_t q = 0; q < queries.size(); q++) {
+		for (size_t i = 0; i < words.size(); i++)
+			checksum += distance(queries[q], words[i]);
+	}
+	double time = elapsedSeconds(start);
+
+	cout << name << ": " << time * 1e9 / (queries.size() * words.size()) << " ns/distance, ";
+	cout << time * 1e3 / queries.size() << " ms/dictionary scan, checksum " << checksum << endl;
+	report.reportAdd("distance", name, "dictionary_scan", time * 1e9 / (queries.size() * words.size()), "ns/distance");
+}
+
+/*
+ * Times the kernel on generated misspellings paired with the words they came from, one
+ * word length class at a time: close pairs, where a banded kernel cannot stop early. Every
+ * kernel gets the same pairs for the same seed
+ * @param kernel label, distance kernel, dictionary words, misspelling seed
+ */
+void benchDistanceClasses(const string &name, DistanceFunction distance, const vector<string> &words, unsigned int seed) {
+	long long checksum = 0;
+	cout << name << " by word length:";
+	for (size_t c = 0; c < sizeof(lengthClasses) / sizeof(lengthClasses[0]); c++) {
+		vector<string> classWords;
+		for (size_t i = 0; i < words.size(); i++) {
+			if (words[i].length() >= lengthClasses[c].shortest && words[i].length() <= lengthClasses[c].longest)
+				classWords.push_back(words[i]);
+		}
+
+		vector<string> misspellings, sources;
+		MisspellingGenerator generator(seed + (unsigned int)c);
+		generator.generate(classWords, BENCH_DISTANCE_PAIRS, SUGGESTION_MAX_DISTANCE, [](const string &) { return false; }, misspellings, sources);
+
+		benchClock::time_point start = benchClock::now();
+		for (size_t i = 0; i < misspellings.size(); i++)
+			checksum += distance(misspellings[i], sources[i]);
+		double time = elapsedSeconds(start);
+
+		cout << " " << lengthClasses[c].name << ": " << time * 1e9 / misspellings.size() << " ns";
+		report.reportAdd("distance", name, string("length_") + lengthClasses[c].name, time * 1e9 / misspellings.size(), "ns/distance");
+	}
+	cout << ", checksum " << checksum << endl;
+}
+
+/*
+ * Times collectSuggestions for every query word with the given options
+ * @param mode label, ptr to loaded dictionary, suggestion options and query words
+ */
+void benchSuggest(const string &name, Dictionary *dictionary, SuggestOptions *options, const vector<string> &queries) {
+	size_t found = 0;
+	benchClock::time_point start = benchClock::now();
+	for (size_t q = 0; q < queries.size(); q++) {
+		vector<string> suggestions;
+		collectSuggestions(dictionary, options, queries[q], suggestions);
+		found += suggestions.size();
+	}
+	double time = elapsedSeconds(start);
+
+	cout << name << ": " << time * 1e6 / queries.size() << " us/misspelling, " << found << " suggestions" << endl;
+	report.reportAdd("suggest", name, "mean", time * 1e6 / queries.size(), "us/misspelling");
+}
+
+/*
+ * Times collectSuggestions for every generated misspelling on its own and prints the
+ * latency distribution, along with the share of misspellings whose source word was
+ * suggested. The result filters (same first letter, no shorter than the misspelling) bound
+ * that share for every mode alike
+ * @param mode label, ptr to loaded dictionary, suggestion options, misspellings and the words they came from
+ */
+void benchLatency(const string &name, Dictionary *dictionary, SuggestOptions *options, const vector<string> &queries, const vector<string> &sources) {
+	vector<double> latencies(queries.size());
+	size_t recalled = 0;
+	for (size_t q = 0; q < queries.size(); q++) {
+		vector<string> suggestions;
+		benchClock::time_point start = benchClock::now();
+		collectSuggestions(dictionary, options, queries[q], suggestions);
+		latencies[q] = elapsedSeconds(start);
+		recalled += std::find(suggestions.begin(), suggestions.end(), sources[q]) != suggestions.end();
+	}
+
+	double total = 0;
+	for (size_t q = 0; q < latencies.size(); q++)
+		total += latencies[q];
+	std::sort(latencies.begin(), latencies.end());
+
+	double mean = total * 1e6 / latencies.size();
+	double p50 = latencies[latencies.size() / 2] * 1e6;
+	double p99 = latencies[latencies.size() * 99 / 100] * 1e6;
+	double recall = (double)recalled / queries.size();
+	cout << "  " << name << ": mean " << mean << " us, p50 " << p50 << " us, p99 " << p99 << " us, source word suggested for " << recall * 100 << "%" << endl;
+
+	report.reportAdd("latency", name, "mean", mean, "us");
+	report.reportAdd("latency", name, "p50", p50, "us");
+	report.reportAdd("latency", name, "p99", p99, "us");
+	report.reportAdd("latency", name, "recall", recall, "fraction");
+}
+
+/*
+ * Checks a stream of misspellings in which a few recur often, as in real text: each is
+ * drawn from misspellings with probability proportional to 1 / rank. Times collectSuggestions
+ * with no cache and with caches of several sizes, checking every cached answer against the
+ * uncached one, and prints hit rates and evictions. Then puts and removes a word to check
+ * that the cache drops its entries when the dictionary changes
+ * @param ptr to loaded dictionary, suggestion options, distinct misspellings, seed of the draw
+ */
+void benchCache(Dictionary *dictionary, SuggestOptions *options, const vector<string> &misspellings, unsigned int seed) {
+	vector<double> cumulative(misspellings.size());
+	double total = 0;
+	for (size_t i = 0; i < misspellings.size(); i++)
+		cumulative[i] = total += 1.0 / (i + 1);
+
+	// drawn from mt19937 directly, like MisspellingGenerator, so a seed gives the same stream everywhere
+	std::mt19937 random(seed);
+	vector<size_t> stream(BENCH_CACHE_QUERIES);
+	for (size_t q = 0; q < stream.size(); q++) {
+		double u = random() / 4294967296.0 * total;
+		stream[q] = std::upper_bound(cumulative.begin(), cumulative.end(), u) - cumulative.begin();
+		stream[q] = stream[q] < misspellings.size() ? stream[q] : misspellings.size() - 1;
+	}
+
+	vector<vector<string> > expected(misspellings.size());
+	for (size_t i = 0; i < misspellings.size(); i++)
+		collectSuggestions(dictionary, options, misspellings[i], expected[i]);
+
+	const size_t entries[] = { 0, 16, 64, 256 };
+	for (size_t e = 0; e < sizeof(entries) / sizeof(entries[0]); e++) {
+		SuggestionCache cache(entries[e]);
+		options->cache = entries[e] ? &cache : nullptr;
+
+		size_t wrong = 0;
+		benchClock::time_point start = benchClock::now();
+		for (size_t q = 0; q < stream.size(); q++) {
+			vector<string> suggestions;
+			collectSuggestions(dictionary, options, misspellings[stream[q]], suggestions);
+			wrong += suggestions != expected[stream[q]];
+		}
+		double time = elapsedSeconds(start);
+
+		string name = entries[e] ? "cache of " + std::to_string(entries[e]) + " entries" : "no cache";
+		cout << "  " << name << ": " << time * 1e6 / stream.size() << " us/misspelling";
+		report.reportAdd("cache", name, "suggest", time * 1e6 / stream.size(), "us/op");
+		if (entries[e]) {
+			SuggestionCacheStats stats = cache.cacheStats();
+			double hitRate = (double)stats.hits / (stats.hits + stats.misses);
+			cout << ", hit rate " << hitRate * 100 << "%, " << stats.evictions << " evictions, " << stats.bytes / 1024 << " KB";
+			report.reportAdd("cache", name, "hit_rate", hitRate, "fraction");
+			report.reportAdd("cache", name, "evictions", stats.evictions, "entries");
+		}
+		cout << (wrong ? ", WRONG SUGGESTIONS" : "") << endl;
+
+		// a change to the words must empty the cache before its next answer, a new value of
+		// a word must not
+		if (e + 1 == sizeof(entries) / sizeof(entries[0])) {
+			SuggestionCacheStats kept = cache.cacheStats();
+			dictionary->mapPut("the", 1);
+			for (size_t i = 0; i < misspellings.size(); i++) {
+				vector<string> suggestions;
+				collectSuggestions(dictionary, options, misspellings[i], suggestions);
+			}
+			cout << "  after a value update: " << cache.cacheStats().invalidations - kept.invalidations << " entries invalidated" << endl;
+
+			string added = "benchcacheword";
+			dictionary->mapPut(added, 1);
+			added.assign(added.length(), '#'); // the dictionary keeps its own copy of the word
+			bool found = dictionary->mapContains("benchcacheword");
+			dictionary->mapRemove("benchcacheword");
+
+			SuggestionCacheStats before = cache.cacheStats();
+			for (size_t i = 0; i < misspellings.size(); i++) {
+				vector<string> suggestions;
+				collectSuggestions(dictionary, options, misspellings[i], suggestions);
+			}
+			SuggestionCacheStats after = cache.cacheStats();
+			cout << "  after a mapPut and mapRemove: " << after.hits - before.hits << " of " << misspellings.size() << " misspellings answered from the cache, ";
+			cout << after.invalidations << " entries invalidated" << (found ? "" : ", PUT WORD LOST") << endl;
+		}
+		options->cache = nullptr;
+	}
+}
+
+/*
+ * Compares the original getline load into string keys with the memory mapped load into
+ * string_view keys: load time and growth of the resident set. The mapped load runs first
+ * and is kept in dictionary for the suggestion benchmarks
+ * @param dictionary file name, output dictionary and its mapped file
+ */
+void benchLoad(const string &fname, Dictionary &dictionary, MappedFile &file) {
+	long long resident = processResidentBytes();
+	benchClock::time_point start = benchClock::now();
+	loadDictionary(fname, &dictionary, &file);
+	double time = elapsedSeconds(start);
+	long long mappedResident = processResidentBytes() - resident;
+	cout << "mmap load (string_view keys): " << dictionary.mapSize() << " entries in " << time << " s, +" << mappedResident / 1024 << " KB resident" << endl;
+	report.reportAdd("load", "mmap load (string_view keys)", "time", time, "s");
+	report.reportAdd("load", "mmap load (string_view keys)", "resident", mappedResident / 1024, "KB");
+
+	resident = processResidentBytes();
+	start = benchClock::now();
+	HashMap<string, int> copied(1000);
+	string inputbuffer = "";
+	ifstream dictionaryFile(fname);
+	while (getline(dictionaryFile, inputbuffer)) {
+		if (!inputbuffer.empty())
+			copied.mapPut(inputbuffer, 1);
+	}
+	time = elapsedSeconds(start);
+	long long copiedResident = processResidentBytes() - resident;
+	cout << "getline load (string keys):   " << copied.mapSize() << " entries in " << time << " s, +" << copiedResident / 1024 << " KB resident" << endl;
+	report.reportAdd("load", "getline load (string keys)", "time", time, "s");
+	report.reportAdd("load", "getline load (string keys)", "resident", copiedResident / 1024, "KB");
+}
+
+/*
+ * Compiles the loaded dictionary and its built indexes into a scratch image, then times
+ * attaching the image and reading every index back, the startup cost it replaces, and
+ * checks that each suggestion mode returns the same suggestions from the image
+ * @param ptr to loaded dictionary, suggestion options with built indexes and query words
+ */
+void benchImage(Dictionary *dictionary, SuggestOptions *options, const vector<string> &queries) {
+	benchClock::time_point start = benchClock::now();
+	long long bytes = compileDictionary(BENCH_IMAGE_FILE, dictionary, options);
+	double time = elapsedSeconds(start);
+	if (bytes == -1) {
+		cout << "Failed to write " << BENCH_IMAGE_FILE << endl;
+		return;
+	}
+	cout << "Dictionary image: " << bytes << " bytes written in " << time << " s" << endl;
+
+	CandidateIndex partitions;
+	SymSpellIndex symSpell(SUGGESTION_MAX_DISTANCE);
+	BKTree bkTree(calcLDMyers);
+	Dawg dawg;
+	SuggestOptions imageOptions = *options;
+	imageOptions.partitions = &partitions;
+	imageOptions.symSpell = &symSpell;
+	imageOptions.bkTree = &bkTree;
+	imageOptions.dawg = &dawg;
+
+	long long resident = processResidentBytes();
+	start = benchClock::now();
+	MappedFile file;
+	Dictionary image(1000);
+	int status = loadDictionary(BENCH_IMAGE_FILE, &image, &file);
+	double attach = elapsedSeconds(start);
+	if (status == 0)
+		buildSuggestionIndexes(&image, &imageOptions);
+	time = elapsedSeconds(start);
+	remove(BENCH_IMAGE_FILE);
+	if (status == -1) {
+		cout << "Failed to load " << BENCH_IMAGE_FILE << endl;
+		return;
+	}
+	cout << "  attached " << image.mapSize() << " entries in " << attach << " s, all indexes ready in " << time;
+	cout << " s, +" << (processResidentBytes() - resident) / 1024 << " KB resident" << endl;
+
+	const SuggestMode modes[] = { SUGGEST_SCAN, SUGGEST_PARTITION, SUGGEST_SYMSPELL, SUGGEST_BKTREE, SUGGEST_DAWG };
+	int mismatches = 0;
+	for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+		options->mode = imageOptions.mode = modes[m];
+		for (size_t q = 0; q < queries.size(); q++) {
+			vector<string> expected, actual;
+			collectSuggestions(dictionary, options, queries[q], expected);
+			collectSuggestions(&image, &imageOptions, queries[q], actual);
+			if (expected != actual)
+				mismatches++;
+		}
+	}
+	options->mode = SUGGEST_SCAN;
+	cout << "  " << mismatches << " suggestion lists differ from the text dictionary" << endl;
+}
+
+/*
+ * Loads every word into a map of the given allocator policy, then destroys it, and prints
+ * the load time, the teardown time and the growth of the resident set. Free heap memory is
+ * returned to the system first so earlier runs do not hide the growth
+ * @param allocator label, dictionary words
+ */
+template <typename Map>
+void benchAllocator(const string &name, const vector<string> &words) {
+	malloc_trim(0);
+	long long resident = processResidentBytes();
+	benchClock::time_point start = benchClock::now();
+	Map *map = new Map(1000);
+	for (size_t i = 0; i < words.size(); i++)
+		map->mapPut(words[i], 1);
+	double load = elapsedSeconds(start);
+	long long grown = processResidentBytes() - resident;
+	size_t arena = map->mapAllocBytes();
+
+	start = benchClock::now();
+	delete map;
+	double teardown = elapsedSeconds(start);
+
+	cout << name << ": load " << load << " s, teardown " << teardown << " s, +" << grown / 1024 << " KB resident";
+	if (arena)
+		cout << " (" << arena / 1024 << " KB of arena blocks)";
+	cout << endl;
+
+	report.reportAdd("allocator", name, "load", load, "s");
+	report.reportAdd("allocator", name, "teardown", teardown, "s");
+	report.reportAdd("allocator", name, "resident", grown / 1024, "KB");
+	report.reportAdd("allocator", name, "arena", arena / 1024, "KB");
+}
+
+/*
+ * Inserts every word into a map growing from 1000 buckets, timing each mapPut, and prints
+ * the total load time, the slowest insert and the 99.9th percentile. Every word is looked
+ * up before any pending incremental resize is finished, to check the old table is searched
+ * @param mode label, old buckets moved per operation (0 to resize all at once), dictionary words
+ */
+void benchResize(const string &name, int step, const vector<string> &words) {
+	HashMap<string, int> map(1000);
+	map.mapIncrementalResize(step);
+
+	vector<double> latencies(words.size());
+	benchClock::time_point start = benchClock::now();
+	for (size_t i = 0; i < words.size(); i++) {
+		benchClock::time_point put = benchClock::now();
+		map.mapPut(words[i], (int)i);
+		latencies[i] = elapsedSeconds(put);
+	}
+	double time = elapsedSeconds(start);
+
+	size_t found = 0;
+	for (size_t i = 0; i < words.size(); i++)
+		found += map.mapContains(words[i]);
+	bool resizing = map.mapResizing();
+	map.mapFinishResize();
+
+	std::sort(latencies.begin(), latencies.end());
+	cout << name;
+	if (step > 0)
+		cout << " (" << step << " buckets per operation)";
+	cout << ": load " << time << " s, slowest insert " << latencies.back() * 1e6 << " us, 99.9% under ";
+	cout << latencies[latencies.size() * 999 / 1000] * 1e6 << " us, " << found << " of " << words.size() << " found";
+	cout << (resizing ? " mid-resize" : "") << endl;
+
+	string label = step > 0 ? name + " (" + std::to_string(step) + " buckets per operation)" : name;
+	report.reportAdd("put", label, "load", time, "s");
+	report.reportAdd("put", label, "slowest", latencies.back() * 1e6, "us");
+	report.reportAdd("put", label, "p999", latencies[latencies.size() * 999 / 1000] * 1e6, "us");
+}
+
+/*
+ * Builds the dictionary table from views of the dictionary words three ways: growing from
+ * 1000 buckets with mapPut, reserving every entry up front before mapPut, and mapBulkLoad of
+ * the unique words without duplicate checks. Each table must hold every word
+ * @param dictionary words
+ */
+void benchBulkLoad(const vector<string> &words) {
+	vector<string_view> keys(words.begin(), words.end());
+	const char *names[] = { "mapPut, growing from 1000 buckets", "mapReserve, then mapPut", "mapBulkLoad of unique keys" };
+	for (int mode = 0; mode < 3; mode++) {
+		benchClock::time_point start = benchClock::now();
+		DictionaryTable table(1000);
+		if (mode == 2)
+			table.mapBulkLoad(keys, 1, true);
+		else {
+			if (mode == 1)
+				table.mapReserve((int)keys.size());
+			for (size_t i = 0; i < keys.size(); i++)
+				table.mapPut(keys[i], 1);
+		}
+		double time = elapsedSeconds(start);
+
+		size_t found = 0;
+		for (size_t i = 0; i < keys.size(); i++)
+			found += table.mapContains(keys[i]);
+		cout << names[mode] << ": " << time << " s, " << table.mapCapacity() << " buckets, " << found << " of " << keys.size() << " found" << endl;
+		report.reportAdd("bulk_load", names[mode], "time", time, "s");
+		report.reportAdd("bulk_load", names[mode], "buckets", table.mapCapacity(), "buckets");
+		report.reportAdd("bulk_load", names[mode], "found", found, "keys");
+	}
+}
+
+/*
+ * Freezes the dictionary table into a PerfectHashMap and compares it with the live table:
+ * build time, successful and failed lookups and memory besides the key bytes both share
+ * @param dictionary words, guaranteed misses
+ */
+void benchPerfect(const vector<string> &words, const vector<string> &misses) {
+	vector<string_view> keys(words.begin(), words.end());
+	DictionaryTable table(1000);
+	table.mapBulkLoad(keys, 1, true);
+
+	benchClock::time_point start = benchClock::now();
+	PerfectHashMap<string_view, int, DictionaryHash> frozen(table);
+	double buildTime = elapsedSeconds(start);
+
+	const char *names[] = { "HashMap (chained, WyHash, arena)", "PerfectHashMap (frozen)" };
+	size_t bytes[] = { table.mapCapacity() * sizeof(HashLink<string_view, int> *) + table.mapAllocBytes(), frozen.perfectBytes() };
+	for (int m = 0; m < 2; m++) {
+		size_t found = 0;
+		start = benchClock::now();
+		for (size_t i = 0; i < words.size(); i++)
+			found += m == 0 ? table.mapContains(string_view(words[i])) : frozen.mapContains(string_view(words[i]));
+		double hitTime = elapsedSeconds(start);
+
+		start = benchClock::now();
+		for (size_t i = 0; i < misses.size(); i++)
+			found += m == 0 ? table.mapContains(string_view(misses[i])) : frozen.mapContains(string_view(misses[i]));
+		double missTime = elapsedSeconds(start);
+
+		cout << names[m] << ": contains hit " << hitTime * 1e9 / words.size() << " ns/op, miss " << missTime * 1e9 / misses.size() << " ns/op, ";
+		cout << bytes[m] / 1024 << " KB besides keys" << (found == words.size() ? "" : ", WRONG LOOKUPS");
+		if (m == 1)
+			cout << ", built in " << buildTime << " s with " << (double)frozen.perfectMetadataBits() / frozen.mapSize() << " bits of metadata per key";
+		cout << endl;
+
+		report.reportAdd("perfect", names[m], "contains_hit", hitTime * 1e9 / words.size(), "ns/op");
+		report.reportAdd("perfect", names[m], "contains_miss", missTime * 1e9 / misses.size(), "ns/op");
+		report.reportAdd("perfect", names[m], "memory", bytes[m] / 1024, "KB");
+	}
+	report.reportAdd("perfect", names[1], "build", buildTime, "s");
+	report.reportAdd("perfect", names[1], "metadata", (double)frozen.perfectMetadataBits() / frozen.mapSize(), "bits/key");
+}
+
+/*
+ * Puts Bloom filters of several sizes in front of a dictionary and times its lookups
+ * against the unfiltered table. For each size prints the bytes and bits per key, the false
+ * positive rate measured on the misses against the estimate, and the hit and miss times
+ * @param dictionary words, guaranteed misses
+ */
+void benchFilter(const vector<string> &words, const vector<string> &misses) {
+	vector<string_view> keys(words.begin(), words.end());
+	Dictionary dictionary(1000);
+	dictionary.mapBulkLoad(keys, 1, true);
+	DictionaryHash hash;
+
+	// 0 bits is the table alone, then the sizes of rates near 10%, 1% and 0.1% and a larger one
+	const double bitsPerKey[] = { 0, 4, BloomFilter::filterBitsForRate(.1), BloomFilter::filterBitsForRate(.01), BloomFilter::filterBitsForRate(.001), 16 };
+	for (size_t b = 0; b < sizeof(bitsPerKey) / sizeof(bitsPerKey[0]); b++) {
+		if (bitsPerKey[b] > 0)
+			dictionary.dictionaryFilter(bitsPerKey[b]);
+		const BloomFilter *filter = dictionary.dictionaryFilter();
+
+		size_t accepted = 0;
+		for (size_t i = 0; filter && i < misses.size(); i++)
+			accepted += filter->filterMayContain(hash(string_view(misses[i])));
+
+		double hitTime = 0, missTime = 0;
+		size_t found = 0;
+		for (int run = 0; run < BENCH_FILTER_RUNS; run++) {
+			found = 0;
+			benchClock::time_point start = benchClock::now();
+			for (size_t i = 0; i < words.size(); i++)
+				found += dictionary.mapContains(words[i]);
+			double time = elapsedSeconds(start);
+			hitTime = run == 0 || time < hitTime ? time : hitTime;
+
+			start = benchClock::now();
+			for (size_t i = 0; i < misses.size(); i++)
+				found += dictionary.mapContains(misses[i]);
+			time = elapsedSeconds(start);
+			missTime = run == 0 || time < missTime ? time : missTime;
+		}
+
+		string name = filter ? "Bloom filter, " + std::to_string(bitsPerKey[b]).substr(0, 5) + " bits/key" : "no filter";
+		cout << name << ": contains hit " << hitTime * 1e9 / words.size() << " ns/op, miss " << missTime * 1e9 / misses.size() << " ns/op";
+		if (filter) {
+			double rate = (double)accepted / misses.size();
+			cout << ", " << filter->filterBytes() / 1024 << " KB (" << 8.0 * filter->filterBytes() / words.size() << " bits/key), ";
+			cout << filter->filterHashes() << " bits set per key, false positives " << rate * 100 << "% (estimate ";
+			cout << BloomFilter::filterRate(bitsPerKey[b]) * 100 << "%)";
+			report.reportAdd("filter", name, "false_positive_rate", rate, "ratio");
+			report.reportAdd("filter", name, "memory", 8.0 * filter->filterBytes() / words.size(), "bits/key");
+		}
+		cout << (found == words.size() ? "" : ", WRONG LOOKUPS") << endl;
+
+		report.reportAdd("filter", name, "contains_hit", hitTime * 1e9 / words.size(), "ns/op");
+		report.reportAdd("filter", name, "contains_miss", missTime * 1e9 / misses.size(), "ns/op");
+	}
+}
+
+/*
+ * Returns whether two dictionaries hold the same keys in the same chains, in the same order
+ * @param dictionaries
+ * @return bool indicating whether every bucket matches
+ */
+bool sameChains(const Dictionary &first, const Dictionary &second) {
+	if (first.mapCapacity() != second.mapCapacity() || first.mapSize() != second.mapSize())
+		return false;
+
+	for (int i = 0; i < first.mapCapacity(); i++) {
+		std::vector<string_view> firstKeys, secondKeys;
+		first.mapVisitKeys(i, i + 1, [&](string_view key) { firstKeys.push_back(key); });
+		second.mapVisitKeys(i, i + 1, [&](string_view key) { secondKeys.push_back(key); });
+		if (firstKeys != secondKeys)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Times loadDictionary serially and on pools of 2, 4 and the hardware's number of threads,
+ * reporting the speedup over the serial load, and checks every parallel table has the
+ * serial table's chains. The duplicate checking path is checked the same way with every
+ * word twice, in shuffled order
+ * @param dictionary file name, dictionary words
+ */
+void benchParallelLoad(const string &fname, const vector<string> &words) {
+	MappedFile serialFile;
+	Dictionary serial(1000);
+	benchClock::time_point start = benchClock::now();
+	loadDictionary(fname, &serial, &serialFile);
+	double serialTime = elapsedSeconds(start);
+	cout << "serial load: " << serialTime << " s" << endl;
+	report.reportAdd("parallel_load", "serial", "time", serialTime, "s");
+
+	vector<string_view> duplicated(words.begin(), words.end());
+	duplicated.insert(duplicated.end(), words.begin(), words.end());
+	std::shuffle(duplicated.begin(), duplicated.end(), std::mt19937(1));
+	Dictionary serialDuplicated(1000);
+	serialDuplicated.mapBulkLoad(duplicated, 1, false);
+
+	int threadCounts[] = { 2, 4, (int)std::thread::hardware_concurrency() };
+	for (int t = 0; t < 3; t++) {
+		if (threadCounts[t] < 2 || (t == 2 && threadCounts[t] <= 4))
+			continue;
+
+		ThreadPool pool(threadCounts[t]);
+		MappedFile file;
+		Dictionary parallel(1000);
+		start = benchClock::now();
+		loadDictionary(fname, &parallel, &file, &pool);
+		double time = elapsedSeconds(start);
+
+		Dictionary parallelDuplicated(1000);
+		parallelDuplicated.mapBulkLoad(duplicated, 1, false, &pool);
+
+		cout << "parallel load on " << threadCounts[t] << " threads: " << time << " s, speedup " << serialTime / time << "x, ";
+		cout << (sameChains(serial, parallel) ? "same" : "DIFFERENT") << " table, duplicate checks ";
+		cout << (sameChains(serialDuplicated, parallelDuplicated) ? "same" : "DIFFERENT") << " (" << parallelDuplicated.mapSize() << " entries)" << endl;
+
+		string label = std::to_string(threadCounts[t]) + " threads";
+		report.reportAdd("parallel_load", label, "time", time, "s");
+		report.reportAdd("parallel_load", label, "speedup", serialTime / time, "x");
+		report.reportAdd("parallel_load", label, "same_table", sameChains(serial, parallel), "bool");
+		report.reportAdd("parallel_load", label, "same_duplicate_table", sameChains(serialDuplicated, parallelDuplicated), "bool");
+	}
+}
+
+/*
+ * Counts the heap allocations made by lookups of every word as a string, a string_view and
+ * a C string, and by a suggestion scan for every query. Both should make none; the only
+ * allocations a scan may make are the buffers of result strings too long for the small
+ * string buffer, which are counted separately
+ * @param map of dictionary words, ptr to loaded dictionary, suggestion options, dictionary words, misspellings
+ */
+void benchAllocations(HashMap<string, int> &map, Dictionary *dictionary, SuggestOptions *options, const vector<string> &words, const vector<string> &queries) {
+	size_t found = 0;
+	long long before = heapAllocations;
+	for (size_t i = 0; i < words.size(); i++) {
+		string_view view(words[i]);
+		found += map.mapContains(words[i]) + map.mapContains(view) + map.mapContains(words[i].c_str()) + dictionary->mapContains(view);
+		found += map.mapContains(view.substr(1)) + dictionary->mapContains(view.substr(1)); // mostly misses
+	}
+	long long lookups = heapAllocations - before;
+
+	// reserved up front so growing the result list is not counted
+	vector<string> suggestions;
+	suggestions.reserve(4096);
+	long long scans = 0, results = 0;
+	for (size_t q = 0; q < queries.size(); q++) {
+		suggestions.clear();
+		before = heapAllocations;
+		suggestScan(dictionary, queries[q], options->distance, suggestions);
+		scans += heapAllocations - before;
+
+		for (size_t i = 0; i < suggestions.size(); i++) {
+			if (suggestions[i].capacity() > string().capacity())
+				results++;
+		}
+	}
+
+	cout << "Heap allocations: " << lookups << " in " << words.size() * 6 << " lookups (" << found << " found), ";
+	cout << scans - results << " in " << queries.size() << " suggestion scans besides " << results << " long result strings";
+	cout << (lookups == 0 && scans == results ? "" : " FAILED") << endl;
+
+	report.reportAdd("allocations", "lookups", "allocations", lookups, "allocations");
+	report.reportAdd("allocations", "suggestScan", "allocations", scans - results, "allocations");
+	report.reportAdd("allocations", "suggestScan", "long_results", results, "allocations");
+}
+
+/*
+ * Estimates the heap bytes held by a chained HashMap: the bucket array, one HashLink per
+ * entry and the character buffer of every key too long for the small string buffer
+ * @param loaded map
+ * @return estimated bytes
+ */
+size_t dictionaryBytes(HashMap<string, int> &map) {
+	size_t bytes = map.mapCapacity() * sizeof(HashLink<string, int> *);
+	for (int i = 0; i < map.mapCapacity(); i++) {
+		for (HashLink<string, int> *link = map.mapTableLink(i); link; link = link->getNext()) {
+			bytes += sizeof(HashLink<string, int>);
+			if (link->getKey().capacity() > 15)
+				bytes += link->getKey().capacity() + 1;
+		}
+	}
+
+	return bytes;
+}
+
+/*
+ * Times the suggestion search of options->mode with a pool of 1, 2, 4 ... threads, up to
+ * the hardware thread count (at least 4), and prints the speedup over one thread
+ * @param ptr to loaded dictionary, suggestion options and query words
+ */
+void benchThreads(Dictionary *dictionary, SuggestOptions *options, const vector<string> &queries) {
+	int maxThreads = (int)std::thread::hardware_concurrency();
+	if (maxThreads < 4)
+		maxThreads = 4;
+
+	double serial = 0;
+	for (int threads = 1; threads <= maxThreads; threads *= 2) {
+		ThreadPool pool(threads);
+		options->pool = &pool;
+
+		benchClock::time_point start = benchClock::now();
+		for (size_t q = 0; q < queries.size(); q++) {
+			vector<string> suggestions;
+			collectSuggestions(dictionary, options, queries[q], suggestions);
+		}
+		double time = elapsedSeconds(start);
+		if (threads == 1)
+			serial = time;
+
+		cout << "  " << threads << " threads: " << time * 1e6 / queries.size() << " us/misspelling, speedup " << serial / time << endl;
+
+		string label = std::to_string(threads) + " threads";
+		report.reportAdd("threads", label, "mean", time * 1e6 / queries.size(), "us/misspelling");
+		report.reportAdd("threads", label, "speedup", serial / time, "x");
+	}
+
+	options->pool = nullptr;
+}
+
+/*
+ * Times checkBatch over a synthetic corpus of dictionary words with one misspelling in every
+ * BENCH_BATCH_MISS_RATE words, on pools of 1, 2, 4 ... threads, and checks every run against
+ * the single thread results. Then checks one BENCH_LONG_TOKEN letter token in every
+ * suggestion mode, which must finish without suggestions
+ * @param ptr to loaded dictionary, suggestion options, dictionary words, misspellings
+ */
+void benchBatch(Dictionary *dictionary, SuggestOptions *options, const vector<string> &words, const vector<string> &queries) {
+	vector<string_view> corpus;
+	for (int i = 0; i < BENCH_BATCH_WORDS; i++) {
+		if (i % BENCH_BATCH_MISS_RATE == 0)
+			corpus.push_back(queries[(i / BENCH_BATCH_MISS_RATE) % queries.size()]);
+		else
+			corpus.push_back(words[((size_t)i * 7919) % words.size()]);
+	}
+
+	int maxThreads = (int)std::thread::hardware_concurrency();
+	if (maxThreads < 4)
+		maxThreads = 4;
+
+	double serial = 0;
+	vector<BatchResult> expected;
+	for (int threads = 1; threads <= maxThreads; threads *= 2) {
+		WorkStealingPool pool(threads);
+		vector<BatchResult> results;
+
+		benchClock::time_point start = benchClock::now();
+		checkBatch(corpus, dictionary, options, &pool, results);
+		double time = elapsedSeconds(start);
+		if (threads == 1) {
+			serial = time;
+			expected = results;
+		}
+
+		bool same = true;
+		for (size_t i = 0; i < results.size(); i++) {
+			if (results[i].correct != expected[i].correct || results[i].suggestions != expected[i].suggestions)
+				same = false;
+		}
+
+		cout << "  " << threads << " threads: " << corpus.size() / time << " words/s, speedup " << serial / time;
+		cout << ", " << pool.poolSteals() << " steals" << (same ? "" : ", RESULTS DIFFER") << endl;
+
+		string label = std::to_string(threads) + " threads";
+		report.reportAdd("batch", label, "throughput", corpus.size() / time, "words/s");
+		report.reportAdd("batch", label, "speedup", serial / time, "x");
+		report.reportAdd("batch", label, "steals", pool.poolSteals(), "tasks");
+		report.reportAdd("batch", label, "same_results", same, "bool");
+	}
+
+	string longToken(BENCH_LONG_TOKEN, 'a');
+	vector<string_view> longCorpus(1, longToken);
+	SuggestMode mode = options->mode;
+	const char *modeNames[] = { "suggestScan", "suggestPartitioned", "suggestSymSpell", "suggestBKTree", "suggestDawg" };
+	SuggestMode modes[] = { SUGGEST_SCAN, SUGGEST_PARTITION, SUGGEST_SYMSPELL, SUGGEST_BKTREE, SUGGEST_DAWG };
+	for (int m = 0; m < 5; m++) {
+		WorkStealingPool pool(1);
+		vector<BatchResult> results;
+		options->mode = modes[m];
+
+		benchClock::time_point start = benchClock::now();
+		checkBatch(longCorpus, dictionary, options, &pool, results);
+		double time = elapsedSeconds(start);
+		cout << "  " << BENCH_LONG_TOKEN << " letter token, " << modeNames[m] << ": " << time * 1e6 << " us";
+		cout << (results.size() == 1 && !results[0].correct && results[0].suggestions.empty() ? "" : ", UNEXPECTED RESULT") << endl;
+		report.reportAdd("batch", modeNames[m], "long_token", time * 1e6, "us");
+	}
+	options->mode = mode;
+}
+
+/*
+ * Multi-reader/multi-writer stress run of ConcurrentHashMap. Even numbered words stay in
+ * the map throughout; the writers insert and remove the odd numbered words while the
+ * readers look everything up. A reader must always find every even word, and any odd word
+ * it finds must carry its own index. At the end every word must be present exactly once
+ * @param dictionary words
+ */
+void stressConcurrent(const vector<string> &words) {
+	ConcurrentHashMap<string, int> map(1000);
+	for (size_t i = 0; i < words.size(); i += 2)
+		map.mapPut(words[i], (int)i);
+
+	std::atomic<bool> writing(true);
+	std::atomic<long long> reads(0), failures(0);
+	vector<std::thread> threads;
+	for (int r = 0; r < BENCH_CONCURRENT_READERS; r++) {
+		threads.push_back(std::thread([&, r] {
+			long long done = 0;
+			do {
+				for (size_t i = r; i < words.size(); i += BENCH_CONCURRENT_READERS) {
+					int value;
+					bool found = map.mapGet(words[i], value);
+					if ((i % 2 == 0 && !found) || (found && value != (int)i))
+						failures++;
+					done++;
+				}
+			} while (writing);
+			reads += done;
+		}));
+	}
+
+	vector<std::thread> writers;
+	for (int w = 0; w < BENCH_CONCURRENT_WRITERS; w++) {
+		writers.push_back(std::thread([&, w] {
+			for (int round = 0; round <= BENCH_CONCURRENT_ROUNDS; round++) {
+				for (size_t i = 1 + 2 * w; i < words.size(); i += 2 * BENCH_CONCURRENT_WRITERS)
+					map.mapPut(words[i], (int)i);
+
+				if (round == BENCH_CONCURRENT_ROUNDS)
+					break;
+
+				for (size_t i = 1 + 2 * w; i < words.size(); i += 2 * BENCH_CONCURRENT_WRITERS) {
+					if (!map.mapRemove(words[i]))
+						failures++;
+				}
+			}
+		}));
+	}
+
+	for (size_t i = 0; i < writers.size(); i++)
+		writers[i].join();
+	writing = false;
+	for (size_t i = 0; i < threads.size(); i++)
+		threads[i].join();
+
+	for (size_t i = 0; i < words.size(); i++) {
+		int value;
+		if (!map.mapGet(words[i], value) || value != (int)i)
+			failures++;
+	}
+	if (map.mapSize() != (int)words.size())
+		failures++;
+
+	cout << "ConcurrentHashMap stress: " << BENCH_CONCURRENT_READERS << " readers, " << BENCH_CONCURRENT_WRITERS << " writers, ";
+	cout << reads << " reads, " << failures << " failures, " << map.mapPendingReclaim() << " objects awaiting reclamation" << endl;
+
+	report.reportAdd("concurrent", "ConcurrentHashMap stress", "reads", reads, "reads");
+	report.reportAdd("concurrent", "ConcurrentHashMap stress", "failures", failures, "failures");
+	report.reportAdd("concurrent", "ConcurrentHashMap stress", "pending_reclaim", map.mapPendingReclaim(), "objects");
+}
+
+/*
+ * Times BENCH_CONCURRENT_READERS threads looking up every dictionary word once while
+ * BENCH_CONCURRENT_WRITERS threads insert and remove misspelled copies of the words
+ * @param display name, dictionary words
+ */
+template <typename Map>
+void benchConcurrent(const string &name, const vector<string> &words) {
+	Map map(1000);
+	for (size_t i = 0; i < words.size(); i++)
+		map.mapPut(words[i], 1);
+
+	std::atomic<long long> found(0);
+	vector<std::thread> threads;
+	benchClock::time_point start = benchClock::now();
+	for (int r = 0; r < BENCH_CONCURRENT_READERS; r++) {
+		threads.push_back(std::thread([&] {
+			long long hits = 0;
+			for (size_t i = 0; i < words.size(); i++)
+				hits += map.mapContains(words[i]);
+			found += hits;
+		}));
+	}
+
+	for (int w = 0; w < BENCH_CONCURRENT_WRITERS; w++) {
+		threads.push_back(std::thread([&, w] {
+			for (size_t i = w; i < words.size(); i += BENCH_CONCURRENT_WRITERS * 8) {
+				map.mapPut(words[i] + "#", 1);
+				map.mapRemove(words[i] + "#");
+			}
+		}));
+	}
+
+	for (size_t i = 0; i < threads.size(); i++)
+		threads[i].join();
+	double time = elapsedSeconds(start);
+
+	long long reads = (long long)words.size() * BENCH_CONCURRENT_READERS;
+	cout << name << ": " << reads / time << " reads/s with concurrent writers, " << found << " of " << reads << " found" << endl;
+
+	report.reportAdd("concurrent", name, "throughput", reads / time, "reads/s");
+	report.reportAdd("concurrent", name, "found", found, "reads");
+}
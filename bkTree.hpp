@@ -0,0 +1,251 @@
+/*
+ * Alex Li
+ * bkTree header
+ */
+
+#pragma once
+#include "editDistance.hpp"
+#include "imageStream.hpp"
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using std::string;
+using std::string_view;
+
+/*
+ * Burkhard-Keller tree over the dictionary words with Levenshtein distance as the metric.
+ * Each child edge is labelled with the child's distance to its parent, so by the triangle
+ * inequality a search of radius r from a node at distance d only has to descend into the
+ * children labelled d - r ... d + r. Nodes live in one array; after treeBuild() every
+ * node's children are stored contiguously and sorted by edge label. Words are kept back to
+ * back in a single character pool.
+ */
+class BKTree {
+public:
+	/*
+	 * Parameterized BKTree constructor. The metric must return exact Levenshtein distances
+	 * (calcLD or calcLDMyers), not a bounded distance
+	 * @param distance kernel used as the metric
+	 */
+	BKTree(DistanceFunction metric) : mMetric(metric), mNodesVisited(0), mLastVisits(0) {}
+
+	/*
+	 * Inserts a word below the existing nodes, following the child edge labelled with the
+	 * word's distance at each level. Duplicate words are ignored. treeBuild() must be called
+	 * after the last word is added and before searching
+	 * @param word
+	 */
+	void treeAdd(const string &word) {
+		if (mNodes.empty()) {
+			addNode(word, 0);
+			return;
+		}
+
+		int current = 0;
+		while (true) {
+			int d = mMetric(treeWord(mNodes[current].word), word);
+			if (d == 0)
+				return;
+
+			// find the child edge labelled d among the siblings
+			int child = mNodes[current].firstChild;
+			while (child != -1 && mNodes[child].edge != d)
+				child = mSiblings[child];
+
+			if (child == -1) {
+				int added = addNode(word, d);
+				mSiblings[added] = mNodes[current].firstChild;
+				mNodes[current].firstChild = added;
+				mNodes[current].childCount++;
+				return;
+			}
+
+			current = child;
+		}
+	}
+
+	/*
+	 * Lays the nodes out again in breadth first order so the children of every node are
+	 * contiguous and sorted by edge label, then drops the sibling links used while inserting
+	 */
+	void treeBuild() {
+		if (mNodes.empty())
+			return;
+
+		std::vector<Node> ordered;
+		ordered.reserve(mNodes.size());
+		std::vector<int> source(1, 0); // old index of each node in ordered
+		ordered.push_back(mNodes[0]);
+
+		for (size_t i = 0; i < ordered.size(); i++) {
+			std::vector<int> children;
+			for (int child = mNodes[source[i]].firstChild; child != -1; child = mSiblings[child])
+				children.push_back(child);
+
+			std::sort(children.begin(), children.end(), EdgeOrder(mNodes));
+			ordered[i].firstChild = (int)ordered.size();
+			for (size_t c = 0; c < children.size(); c++) {
+				ordered.push_back(mNodes[children[c]]);
+				source.push_back(children[c]);
+			}
+		}
+
+		mNodes.swap(ordered);
+		std::vector<int>().swap(mSiblings);
+	}
+
+	/*
+	 * Collects the ids of every word within radius of word. Only subtrees whose edge label
+	 * lies within radius of the current node's distance are visited. Safe to call from
+	 * several threads at once; the visit counters are atomic
+	 * @param word, search radius, output word ids
+	 */
+	void treeSearch(const string &word, int radius, std::vector<int> &ids) {
+		if (mNodes.empty())
+			return;
+
+		int visits = 0;
+		std::vector<int> stack(1, 0);
+		while (!stack.empty()) {
+			const Node &node = mNodes[stack.back()];
+			stack.pop_back();
+			visits++;
+
+			int d = mMetric(treeWord(node.word), word);
+			if (d <= radius)
+				ids.push_back(node.word);
+
+			for (int c = node.firstChild; c < node.firstChild + node.childCount; c++) {
+				if (mNodes[c].edge > d + radius)
+					break;
+
+				if (mNodes[c].edge >= d - radius)
+					stack.push_back(c);
+			}
+		}
+
+		mLastVisits = visits;
+		mNodesVisited += visits;
+	}
+
+	/*
+	 * Returns the word with the given id
+	 * @param word id
+	 * @return indexed word
+	 */
+	string_view treeWord(int id) const { return string_view(mPool).substr(mOffsets[id], mLengths[id]); }
+
+	/*
+	 * Returns the number of nodes (distinct words) in the tree
+	 * @return number of nodes
+	 */
+	int treeSize() const { return (int)mNodes.size(); }
+
+	/*
+	 * Returns the number of bytes held by the node array and word pool
+	 * @return tree size in bytes
+	 */
+	size_t treeBytes() const {
+		return mNodes.capacity() * sizeof(Node) + mPool.capacity() + (mOffsets.capacity() + mLengths.capacity()) * sizeof(int);
+	}
+
+	/*
+	 * Returns the number of nodes whose distance was computed by the last search
+	 * @return nodes visited by last search
+	 */
+	int treeLastVisits() const { return mLastVisits; }
+
+	/*
+	 * Returns the number of nodes whose distance was computed by all searches so far
+	 * @return total nodes visited
+	 */
+	long long treeNodesVisited() const { return mNodesVisited; }
+
+	/*
+	 * Writes the built tree to a dictionary image: the node array and the word pool
+	 * @param image writer
+	 */
+	void treeSave(ImageWriter &out) const {
+		out.writeArray(mNodes.data(), mNodes.size());
+		out.writeArray(mPool.data(), mPool.length());
+		out.writeArray(mOffsets.data(), mOffsets.size());
+		out.writeArray(mLengths.data(), mLengths.size());
+	}
+
+	/*
+	 * Replaces the tree with one read from a dictionary image, already laid out, so
+	 * treeBuild() is not needed. The tree is left unchanged if the image cannot be read
+	 * @param image reader
+	 * @return bool indicating whether the tree was read
+	 */
+	bool treeLoad(ImageReader &in) {
+		std::vector<Node> nodes;
+		string pool;
+		std::vector<int> offsets, lengths;
+		if (!in.readVector(nodes) || !in.readString(pool) || !in.readVector(offsets) || !in.readVector(lengths))
+			return false;
+
+		if (offsets.size() != lengths.size())
+			return false;
+
+		for (size_t i = 0; i < offsets.size(); i++) {
+			if (offsets[i] < 0 || lengths[i] < 0 || (size_t)offsets[i] + lengths[i] > pool.length())
+				return false;
+		}
+
+		for (size_t i = 0; i < nodes.size(); i++) {
+			if (nodes[i].word < 0 || nodes[i].word >= (int)offsets.size() || nodes[i].firstChild < 0 || nodes[i].childCount < 0 || (size_t)nodes[i].firstChild + nodes[i].childCount > nodes.size())
+				return false;
+		}
+
+		mNodes.swap(nodes);
+		mPool.swap(pool);
+		mOffsets.swap(offsets);
+		mLengths.swap(lengths);
+		std::vector<int>().swap(mSiblings);
+		return true;
+	}
+
+private:
+	struct Node {
+		int word; // word id
+		int edge; // distance to parent
+		int firstChild; // array index of first child (head of sibling list before treeBuild)
+		int childCount;
+	};
+
+	/*
+	 * Appends word to the pool and a childless node for it to the node array
+	 * @param word, distance to parent
+	 * @return index of the new node
+	 */
+	int addNode(const string &word, int edge) {
+		Node node = { (int)mOffsets.size(), edge, -1, 0 };
+		mOffsets.push_back((int)mPool.size());
+		mLengths.push_back((int)word.length());
+		mPool.append(word);
+
+		mNodes.push_back(node);
+		mSiblings.push_back(-1);
+		return (int)mNodes.size() - 1;
+	}
+
+	// orders node indexes by the edge label of the node
+	struct EdgeOrder {
+		EdgeOrder(const std::vector<Node> &nodes) : mNodes(nodes) {}
+		bool operator()(int a, int b) const { return mNodes[a].edge < mNodes[b].edge; }
+		const std::vector<Node> &mNodes;
+	};
+
+	DistanceFunction mMetric;
+	std::vector<Node> mNodes;
+	std::vector<int> mSiblings; // next sibling of each node, only used before treeBuild()
+	string mPool; // all words back to back
+	std::vector<int> mOffsets; // pool offset of each word
+	std::vector<int> mLengths; // length of each word
+	std::atomic<long long> mNodesVisited; // nodes visited by all searches
+	std::atomic<int> mLastVisits; // nodes visited by the last search
+};
@@ -0,0 +1,212 @@
+/*
+ * Alex Li
+ * bloomFilter header
+ */
+
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#define FILTER_BLOCK_SHIFT 9 // log2 of FILTER_BLOCK_BITS
+#define FILTER_BLOCK_BITS (1 << FILTER_BLOCK_SHIFT) // bits per block, one 64 byte cache line
+#define FILTER_MAX_HASHES 16 // bits set per key at most, more cost probes for little gain
+#define FILTER_DEFAULT_RATE .01 // false positive rate of a filter asked for without one
+#define FILTER_MAX_BITS 64 // bits per key filterBitsForRate gives at most
+#define FILTER_BITS_STEP (1.0 / 16) // resolution of filterBitsForRate
+
+// one cache line of filter bits
+struct alignas(64) FilterBlock {
+	unsigned long long words[FILTER_BLOCK_BITS / 64];
+};
+
+/*
+ * Blocked Bloom filter over the policy hashes of a table's keys. Each key sets all of its
+ * bits in a single cache line chosen by its hash, so a query reads one line: a key the
+ * filter rejects is certainly absent, a key it accepts must still be looked up. Blocking
+ * raises the false positive rate over a classic Bloom filter of the same size, since some
+ * blocks hold more keys than average: at 14.4 bits per key, 0.25% instead of 0.1%. The
+ * filter is therefore sized with the rate of the blocked layout (see filterRate), which
+ * takes a few more bits per key for the same rate. Keys can be added after the build, but
+ * never removed
+ */
+class BloomFilter {
+public:
+	/*
+	 * Default BloomFilter constructor, disabled until filterInit
+	 */
+	BloomFilter() : mHashes(0) {}
+
+	/*
+	 * Returns the expected false positive rate of a filter with the given bits per key and
+	 * bits set per key. The keys of a block follow a Poisson distribution around
+	 * FILTER_BLOCK_BITS / bitsPerKey, and a block holding n keys accepts a miss with the
+	 * classic rate of a FILTER_BLOCK_BITS bit filter of n keys
+	 * @param bits per key, bits set per key
+	 * @return false positive rate
+	 */
+	static double filterRate(double bitsPerKey, int hashes) {
+		double mean = FILTER_BLOCK_BITS / bitsPerKey;
+		double unset = std::log1p(-1.0 / FILTER_BLOCK_BITS); // ln of the chance one bit stays clear
+		double rate = 0;
+		int last = (int)(mean + 12 * std::sqrt(mean) + 32);
+		for (int keys = 0; keys <= last; keys++) {
+			double weight = std::exp(-mean + keys * std::log(mean) - std::lgamma(keys + 1.0));
+			rate += weight * std::pow(-std::expm1(unset * hashes * keys), hashes);
+		}
+		return rate;
+	}
+
+	/*
+	 * Returns the expected false positive rate of a filter with the given bits per key,
+	 * setting the bits per key filterInit chooses
+	 * @param bits per key
+	 * @return false positive rate
+	 */
+	static double filterRate(double bitsPerKey) { return filterRate(bitsPerKey, hashesFor(bitsPerKey)); }
+
+	/*
+	 * Returns the fewest bits per key, in steps of FILTER_BITS_STEP, whose filterRate is at
+	 * most the given rate, or FILTER_MAX_BITS for rates no filter that small reaches
+	 * @param false positive rate in (0, 1)
+	 * @return bits per key
+	 */
+	static double filterBitsForRate(double rate) {
+		double bits = -std::log(rate) / (std::log(2.0) * std::log(2.0)); // classic size, a lower bound
+		bits = std::floor(bits / FILTER_BITS_STEP) * FILTER_BITS_STEP;
+		while (bits < FILTER_MAX_BITS && filterRate(bits) > rate)
+			bits += FILTER_BITS_STEP;
+		return bits < FILTER_MAX_BITS ? bits : FILTER_MAX_BITS;
+	}
+
+	/*
+	 * Clears the filter and sizes it for a number of keys, setting the number of bits per
+	 * key with the lowest filterRate. Returns 0 on success and -1 if bitsPerKey is not positive
+	 * @param expected number of keys, bits per key
+	 * @return int indicating whether the filter was sized
+	 */
+	int filterInit(size_t keys, double bitsPerKey) {
+		if (!(bitsPerKey > 0))
+			return -1;
+
+		size_t blocks = (size_t)std::ceil(keys * bitsPerKey / FILTER_BLOCK_BITS);
+		mBlocks.assign(blocks ? blocks : 1, FilterBlock());
+		mHashes = hashesFor(bitsPerKey);
+		return 0;
+	}
+
+	/*
+	 * Disables the filter and frees its blocks
+	 */
+	void filterClear() {
+		std::vector<FilterBlock>().swap(mBlocks);
+		mHashes = 0;
+	}
+
+	/*
+	 * Adds a key by its policy hash
+	 * @param policy hash
+	 */
+	void filterAdd(unsigned long long hash) {
+		FilterBlock &block = mBlocks[blockIndex(hash)];
+		unsigned long long bits = filterMix(hash ^ 0x9e3779b97f4a7c15ULL);
+		for (int i = 0; i < mHashes; i++) {
+			unsigned int bit = bitIndex(bits, i);
+			block.words[bit / 64] |= 1ULL << (bit % 64);
+		}
+	}
+
+	/*
+	 * Returns false if the key with the given policy hash was certainly never added
+	 * @param policy hash
+	 * @return bool indicating whether the key may have been added
+	 */
+	bool filterMayContain(unsigned long long hash) const {
+		const FilterBlock &block = mBlocks[blockIndex(hash)];
+		unsigned long long bits = filterMix(hash ^ 0x9e3779b97f4a7c15ULL);
+		for (int i = 0; i < mHashes; i++) {
+			unsigned int bit = bitIndex(bits, i);
+			if (!(block.words[bit / 64] & (1ULL << (bit % 64))))
+				return false;
+		}
+		return true;
+	}
+
+	/*
+	 * Returns whether the filter was sized by filterInit
+	 * @return bool indicating whether the filter is in use
+	 */
+	bool filterEnabled() const { return mHashes != 0; }
+
+	/*
+	 * Returns the bytes of filter bits
+	 * @return filter bytes
+	 */
+	size_t filterBytes() const { return mBlocks.size() * sizeof(FilterBlock); }
+
+	/*
+	 * Returns the bits set per key
+	 * @return number of hash functions
+	 */
+	int filterHashes() const { return mHashes; }
+
+private:
+	/*
+	 * Returns the bits set per key, up to FILTER_MAX_HASHES, with the lowest filterRate. It
+	 * comes out a little below the classic ln(2) * bitsPerKey, since crowded blocks favour
+	 * fewer bits
+	 * @param bits per key
+	 * @return bits set per key
+	 */
+	static int hashesFor(double bitsPerKey) {
+		int best = 1;
+		for (int hashes = 2; hashes <= FILTER_MAX_HASHES; hashes++) {
+			if (filterRate(bitsPerKey, hashes) < filterRate(bitsPerKey, best))
+				best = hashes;
+		}
+		return best;
+	}
+
+	/*
+	 * splitmix64 finalizer, spreads the policy hash so weak policies still fill the blocks
+	 * @param x
+	 * @return mixed x
+	 */
+	static unsigned long long filterMix(unsigned long long x) {
+		x ^= x >> 30;
+		x *= 0xbf58476d1ce4e5b9ULL;
+		x ^= x >> 27;
+		x *= 0x94d049bb133111ebULL;
+		return x ^ (x >> 31);
+	}
+
+	/*
+	 * Returns the i-th bit of a key within its block: the top bits of the key's mixed hash
+	 * times the i-th of FILTER_MAX_HASHES odd constants. Unlike double hashing, which walks an
+	 * arithmetic progression through the block, every product gives an independent position
+	 * @param mixed hash, index of the bit
+	 * @return bit within the block
+	 */
+	static unsigned int bitIndex(unsigned long long bits, int i) {
+		static const unsigned long long salts[FILTER_MAX_HASHES] = {
+			0x47b6137b44974d91ULL, 0x8824ad5ba2b7289dULL, 0x705495c72df1424bULL, 0x9efc49475c6bfb31ULL,
+			0xc2b2ae3d27d4eb4fULL, 0x165667b19e3779f9ULL, 0xd6e8feb86659fd93ULL, 0xa0761d6478bd642fULL,
+			0xe7037ed1a0b428dbULL, 0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL, 0x1d8e4e27c47d124fULL,
+			0x9e3779b97f4a7c15ULL, 0xbf58476d1ce4e5b9ULL, 0x94d049bb133111ebULL, 0xff51afd7ed558ccdULL
+		};
+		return (unsigned int)((bits * salts[i]) >> (64 - FILTER_BLOCK_SHIFT));
+	}
+
+	/*
+	 * Returns the block index of a policy hash, chosen by multiply and shift instead of a division
+	 * @param policy hash
+	 * @return block index
+	 */
+	size_t blockIndex(unsigned long long hash) const {
+		unsigned long long high = filterMix(hash) >> 32;
+		return (size_t)((high * mBlocks.size()) >> 32);
+	}
+
+	std::vector<FilterBlock> mBlocks;
+	int mHashes; // bits set per key, 0 while disabled
+};
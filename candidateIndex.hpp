@@ -0,0 +1,164 @@
+/*
+ * Alex Li
+ * candidateIndex header
+ */
+
+#pragma once
+#include "imageStream.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+
+using std::string;
+using std::string_view;
+
+#define INDEX_MAX_LENGTH 65536 // longest word an index image may hold
+
+/*
+ * Secondary index over the dictionary words that groups them by (first character, length).
+ * All words of a partition have the same length, so each partition is stored as one
+ * contiguous block of fixed-width records. A suggestion query only visits the partitions
+ * that can pass its first letter and length filters instead of every table bucket. An
+ * index read from a dictionary image serves its partitions in place from the mapping.
+ */
+class CandidateIndex {
+public:
+	/*
+	 * Default CandidateIndex constructor, creates an empty index
+	 */
+	CandidateIndex() : mSize(0), mMapped(false) {}
+
+	/*
+	 * Appends a word to the partition of its first character and length. Empty words are
+	 * not indexed since they have no first character, and an index read from an image is
+	 * read only
+	 * @param word
+	 */
+	void indexAdd(const string &word) {
+		if (word.empty() || mMapped)
+			return;
+
+		std::vector<std::vector<char> > &lengths = mPartitions[(unsigned char)word[0]];
+		if (word.length() >= lengths.size())
+			lengths.resize(word.length() + 1);
+
+		std::vector<char> &partition = lengths[word.length()];
+		partition.insert(partition.end(), word.begin(), word.end());
+		mSize++;
+	}
+
+	/*
+	 * Returns the number of words in the index
+	 * @return number of words
+	 */
+	int indexSize() const { return mSize; }
+
+	/*
+	 * Returns the number of words in the partition with the given first character and length
+	 * @param first character, word length
+	 * @return number of words in partition
+	 */
+	int indexPartitionSize(char first, int length) const { return length <= 0 ? 0 : (int)records(first, length).length() / length; }
+
+	/*
+	 * Returns the words of the partition with the given first character and length, stored
+	 * back to back without separators. Word n starts at n * length
+	 * @param first character, word length
+	 * @return pointer to partition records or nullptr if partition is empty
+	 */
+	const char* indexPartition(char first, int length) const {
+		if (indexPartitionSize(first, length) == 0)
+			return nullptr;
+
+		return records(first, length).data();
+	}
+
+	/*
+	 * Returns the number of heap bytes held by the partitions. Partitions read from an image
+	 * stay in the mapping, so only their views count
+	 * @return index size in bytes
+	 */
+	size_t indexBytes() const {
+		size_t bytes = 0;
+		for (int c = 0; c < 256; c++) {
+			for (size_t i = 0; i < mPartitions[c].size(); i++)
+				bytes += mPartitions[c][i].capacity();
+			bytes += mViews[c].capacity() * sizeof(string_view);
+		}
+
+		return bytes;
+	}
+
+	/*
+	 * Writes the partitions to a dictionary image
+	 * @param image writer
+	 */
+	void indexSave(ImageWriter &out) const {
+		out.writeValue(mSize);
+		for (int c = 0; c < 256; c++) {
+			size_t lengths = mMapped ? mViews[c].size() : mPartitions[c].size();
+			out.writeValue((unsigned long long)lengths);
+			for (size_t i = 0; i < lengths; i++) {
+				string_view partition = records((char)c, (int)i);
+				out.writeArray(partition.data(), partition.length());
+			}
+		}
+	}
+
+	/*
+	 * Replaces the index with views of the partitions of a dictionary image, which must
+	 * stay mapped for as long as the index is used. The index is left unchanged if the image
+	 * cannot be read
+	 * @param image reader
+	 * @return bool indicating whether the index was read
+	 */
+	bool indexLoad(ImageReader &in) {
+		int size = 0;
+		std::vector<string_view> views[256];
+		if (!in.readValue(size))
+			return false;
+
+		for (int c = 0; c < 256; c++) {
+			unsigned long long lengths = 0;
+			if (!in.readValue(lengths) || lengths > INDEX_MAX_LENGTH)
+				return false;
+
+			views[c].resize(lengths);
+			for (size_t i = 0; i < lengths; i++) {
+				size_t count = 0;
+				const char *partition = in.readArray<char>(count);
+				if (!partition)
+					return false;
+				views[c][i] = string_view(partition, count);
+			}
+		}
+
+		for (int c = 0; c < 256; c++) {
+			mViews[c].swap(views[c]);
+			std::vector<std::vector<char> >().swap(mPartitions[c]);
+		}
+		mSize = size;
+		mMapped = true;
+		return true;
+	}
+
+private:
+	/*
+	 * Returns the records of a partition, built or mapped
+	 * @param first character, word length
+	 * @return partition records, empty if there are none
+	 */
+	string_view records(char first, int length) const {
+		unsigned char c = (unsigned char)first;
+		if (mMapped)
+			return length < (int)mViews[c].size() ? mViews[c][length] : string_view();
+
+		const std::vector<std::vector<char> > &lengths = mPartitions[c];
+		return length < (int)lengths.size() ? string_view(lengths[length].data(), lengths[length].size()) : string_view();
+	}
+
+	std::vector<std::vector<char> > mPartitions[256]; // [first character][length] word records of a built index
+	std::vector<string_view> mViews[256]; // [first character][length] word records of an index read from an image
+	int mSize; // number of indexed words
+	bool mMapped; // whether the records are mViews into an image
+};
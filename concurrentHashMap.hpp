@@ -0,0 +1,259 @@
+/*
+ * Alex Li
+ * concurrentHashMap header
+ */
+
+#pragma once
+#include "epochReclaimer.hpp"
+#include "hashPolicy.h"
+#include <atomic>
+#include <mutex>
+
+#define CONCURRENT_SHARD_BITS 4 // 16 shards
+#define CONCURRENT_SHARDS (1 << CONCURRENT_SHARD_BITS)
+#define CONCURRENT_MIN_SHARD_CAPACITY 8
+#define CONCURRENT_MAX_TABLE_LOAD .75
+
+/*
+ * Separate chaining hash table that can be read and written from many threads at once.
+ * Keys are split into CONCURRENT_SHARDS shards by the top bits of their hash, and each shard
+ * is an independent chained table with its own writer mutex, so writers only serialize with
+ * writers of the same shard. Readers never lock: mapContains() and mapGet() walk the chains
+ * through atomic pointers inside an epoch read section (see epochReclaimer.hpp).
+ *
+ * Writers never change a node a reader may be looking at. An update links in a new node in
+ * place of the old one, a removal unlinks the node, and a resize builds a complete copy of
+ * the shard's table and publishes it with one pointer store. Replaced nodes and tables are
+ * retired and freed only once every reader that might still see them has left.
+ */
+template <typename K, typename V, typename Hash = WyHash>
+class ConcurrentHashMap {
+public:
+	/*
+	 * Parameterized ConcurrentHashMap constructor
+	 * @param capacity, spread over the shards
+	 */
+	ConcurrentHashMap(int capacity) {
+		int shardCapacity = capacity / CONCURRENT_SHARDS;
+		if (shardCapacity < CONCURRENT_MIN_SHARD_CAPACITY)
+			shardCapacity = CONCURRENT_MIN_SHARD_CAPACITY;
+
+		for (int i = 0; i < CONCURRENT_SHARDS; i++) {
+			mShards[i].table.store(new Table(shardCapacity));
+			mShards[i].size.store(0);
+		}
+	}
+
+	/*
+	 * ConcurrentHashMap destructor, frees every table and node. No other thread may be using
+	 * the map
+	 */
+	~ConcurrentHashMap() {
+		for (int i = 0; i < CONCURRENT_SHARDS; i++)
+			destroyTable(mShards[i].table.load());
+	}
+
+	/*
+	 * Copies the value stored under key into value. Never blocks
+	 * @param key, output value
+	 * @return bool indicating whether key exists in table
+	 */
+	bool mapGet(const K &key, V &value) {
+		EpochGuard guard(mReclaimer);
+		Node *node = findNode(key);
+		if (node == nullptr)
+			return false;
+
+		value = node->value;
+		return true;
+	}
+
+	/*
+	 * Returns whether key is in the table. Never blocks
+	 * @param key
+	 * @return bool indicating whether key exists in table
+	 */
+	bool mapContains(const K &key) {
+		EpochGuard guard(mReclaimer);
+		return findNode(key) != nullptr;
+	}
+
+	/*
+	 * Stores value under key, replacing the node of an existing key. Serialized with the
+	 * other writers of the key's shard
+	 * @param key, value
+	 */
+	void mapPut(const K &key, const V &value) {
+		unsigned long long hash = mHash(key);
+		Shard &shard = mShards[shardIndex(hash)];
+		std::lock_guard<std::mutex> lock(shard.mutex);
+
+		Table *table = shard.table.load(std::memory_order_relaxed);
+		if (shard.size.load(std::memory_order_relaxed) + 1 > table->capacity * CONCURRENT_MAX_TABLE_LOAD)
+			table = resizeShard(shard, table->capacity * 2);
+
+		std::atomic<Node *> &bucket = table->buckets[hash % (unsigned long long)table->capacity];
+		std::atomic<Node *> *link = &bucket;
+		for (Node *node = link->load(std::memory_order_relaxed); node != nullptr; node = link->load(std::memory_order_relaxed)) {
+			if (node->key.compare(key) == 0) {
+				link->store(new Node(key, value, node->next.load(std::memory_order_relaxed)), std::memory_order_release);
+				mReclaimer.epochRetire(node, EpochReclaimer::destroyObject<Node>);
+				return;
+			}
+			link = &node->next;
+		}
+
+		bucket.store(new Node(key, value, bucket.load(std::memory_order_relaxed)), std::memory_order_release);
+		shard.size.fetch_add(1);
+	}
+
+	/*
+	 * Removes key from the table. Serialized with the other writers of the key's shard
+	 * @param key
+	 * @return bool indicating whether key-value pair removal was successful
+	 */
+	bool mapRemove(const K &key) {
+		unsigned long long hash = mHash(key);
+		Shard &shard = mShards[shardIndex(hash)];
+		std::lock_guard<std::mutex> lock(shard.mutex);
+
+		Table *table = shard.table.load(std::memory_order_relaxed);
+		std::atomic<Node *> *link = &table->buckets[hash % (unsigned long long)table->capacity];
+		for (Node *node = link->load(std::memory_order_relaxed); node != nullptr; node = link->load(std::memory_order_relaxed)) {
+			if (node->key.compare(key) == 0) {
+				// a reader standing on node still finds the rest of the chain through node->next
+				link->store(node->next.load(std::memory_order_relaxed), std::memory_order_release);
+				mReclaimer.epochRetire(node, EpochReclaimer::destroyObject<Node>);
+				shard.size.fetch_sub(1);
+				return true;
+			}
+			link = &node->next;
+		}
+
+		return false;
+	}
+
+	/*
+	 * Returns the number of keys in the table. Exact only while no writer is active
+	 * @return number of keys
+	 */
+	int mapSize() const {
+		int size = 0;
+		for (int i = 0; i < CONCURRENT_SHARDS; i++)
+			size += mShards[i].size.load();
+
+		return size;
+	}
+
+	/*
+	 * Returns the number of buckets over all shards
+	 * @return number of buckets
+	 */
+	int mapCapacity() const {
+		int capacity = 0;
+		for (int i = 0; i < CONCURRENT_SHARDS; i++)
+			capacity += mShards[i].table.load()->capacity;
+
+		return capacity;
+	}
+
+	/*
+	 * Returns the number of retired nodes and tables waiting for readers to leave
+	 * @return objects pending reclamation
+	 */
+	size_t mapPendingReclaim() { return mReclaimer.epochPending(); }
+
+private:
+	struct Node {
+		Node(const K &k, const V &v, Node *n) : key(k), value(v), next(n) {}
+		const K key;
+		const V value;
+		std::atomic<Node *> next;
+	};
+
+	struct Table {
+		Table(int cap) : capacity(cap), buckets(new std::atomic<Node *>[cap]) {
+			for (int i = 0; i < cap; i++)
+				buckets[i].store(nullptr, std::memory_order_relaxed);
+		}
+		~Table() { delete[] buckets; }
+		int capacity;
+		std::atomic<Node *> *buckets;
+	};
+
+	struct alignas(64) Shard {
+		std::mutex mutex; // serializes writers of this shard
+		std::atomic<Table *> table;
+		std::atomic<int> size;
+	};
+
+	/*
+	 * Returns the shard of a hash, taken from its top bits so the bucket index (the hash
+	 * modulo the capacity) stays independent of it
+	 * @return shard index
+	 */
+	static int shardIndex(unsigned long long hash) { return (int)(hash >> (64 - CONCURRENT_SHARD_BITS)); }
+
+	/*
+	 * Returns the node holding key, or nullptr. Must run inside an epoch read section
+	 * @param key
+	 * @return node or nullptr
+	 */
+	Node* findNode(const K &key) {
+		unsigned long long hash = mHash(key);
+		Table *table = mShards[shardIndex(hash)].table.load(std::memory_order_acquire);
+
+		Node *node = table->buckets[hash % (unsigned long long)table->capacity].load(std::memory_order_acquire);
+		while (node != nullptr) {
+			if (node->key.compare(key) == 0)
+				return node;
+
+			node = node->next.load(std::memory_order_acquire);
+		}
+		return nullptr;
+	}
+
+	/*
+	 * Copies every node of the shard into a new table of newCapacity buckets, publishes it
+	 * and retires the old table together with its nodes. Readers still walking the old
+	 * table see it unchanged. Called with the shard's mutex held
+	 * @param shard, new capacity
+	 * @return new table
+	 */
+	Table* resizeShard(Shard &shard, int newCapacity) {
+		Table *oldTable = shard.table.load(std::memory_order_relaxed);
+		Table *newTable = new Table(newCapacity);
+
+		for (int i = 0; i < oldTable->capacity; i++) {
+			for (Node *node = oldTable->buckets[i].load(std::memory_order_relaxed); node != nullptr; node = node->next.load(std::memory_order_relaxed)) {
+				std::atomic<Node *> &bucket = newTable->buckets[mHash(node->key) % (unsigned long long)newCapacity];
+				bucket.store(new Node(node->key, node->value, bucket.load(std::memory_order_relaxed)), std::memory_order_relaxed);
+			}
+		}
+
+		shard.table.store(newTable, std::memory_order_release);
+		mReclaimer.epochRetire(oldTable, destroyTable);
+		return newTable;
+	}
+
+	/*
+	 * Frees a table and every node still linked into it
+	 * @param table
+	 */
+	static void destroyTable(void *object) {
+		Table *table = (Table *)object;
+		for (int i = 0; i < table->capacity; i++) {
+			Node *node = table->buckets[i].load(std::memory_order_relaxed);
+			while (node != nullptr) {
+				Node *next = node->next.load(std::memory_order_relaxed);
+				delete node;
+				node = next;
+			}
+		}
+		delete table;
+	}
+
+	Hash mHash;
+	Shard mShards[CONCURRENT_SHARDS];
+	EpochReclaimer mReclaimer;
+};
@@ -0,0 +1,346 @@
+/*
+ * Alex Li
+ * dawg header
+ */
+
+#pragma once
+#include "flatHashMap.hpp"
+#include "imageStream.hpp"
+#include <string>
+#include <vector>
+
+using std::string;
+
+/*
+ * Minimal deterministic acyclic word graph (DAWG) over the dictionary words. Words must be
+ * added in sorted order; the graph is minimized incrementally (Daciuk et al.) by merging
+ * every finished suffix state with an equivalent registered state, so shared prefixes and
+ * shared suffixes are both stored once. dawgBuild() flattens the reachable states into
+ * plain arrays with one contiguous edge range per state.
+ *
+ * dawgSearch() intersects the graph with the Levenshtein automaton of a query word by
+ * walking the graph depth first and carrying one row of the edit distance matrix per depth,
+ * which is the automaton's state. A row is computed once per graph edge on the current
+ * path, so every word sharing that prefix reuses it, and a branch is abandoned as soon as
+ * every cell of its row exceeds the distance bound.
+ */
+class Dawg {
+public:
+	/*
+	 * Default Dawg constructor, creates a graph holding only the root state
+	 */
+	Dawg() : mRegister(new FlatHashMap<string, int>(1000)), mWords(0) {
+		mBuild.push_back(BuildState());
+	}
+
+	/*
+	 * Dawg destructor
+	 */
+	~Dawg() { delete mRegister; }
+
+	Dawg(const Dawg &) = delete;
+	Dawg &operator=(const Dawg &) = delete;
+
+	/*
+	 * Adds a word to the graph. Words must arrive in ascending order; empty words and
+	 * repeats of the previous word are ignored. dawgBuild() must be called after the last
+	 * word is added and before searching
+	 * @param word
+	 */
+	void dawgAdd(const string &word) {
+		if (word.empty() || word.compare(mPrevious) <= 0)
+			return;
+
+		// length of the prefix shared with the previous word
+		size_t prefix = 0;
+		while (prefix < word.length() && prefix < mPrevious.length() && word[prefix] == mPrevious[prefix])
+			prefix++;
+
+		// states past the shared prefix can no longer change, so they are minimized now
+		minimize(prefix);
+
+		int state = mUnchecked.empty() ? 0 : mUnchecked.back().child;
+		for (size_t i = prefix; i < word.length(); i++) {
+			int child = (int)mBuild.size();
+			mBuild.push_back(BuildState());
+			mBuild[state].edges.push_back(Edge(word[i], child));
+
+			Unchecked unchecked = { state, child };
+			mUnchecked.push_back(unchecked);
+			state = child;
+		}
+
+		mBuild[state].final = true;
+		mPrevious = word;
+		mWords++;
+	}
+
+	/*
+	 * Minimizes the remaining states, then flattens every state reachable from the root
+	 * into the final arrays and drops the construction data
+	 */
+	void dawgBuild() {
+		minimize(0);
+
+		// number reachable states breadth first, root first
+		std::vector<int> newId(mBuild.size(), -1);
+		std::vector<int> order(1, 0);
+		newId[0] = 0;
+		for (size_t i = 0; i < order.size(); i++) {
+			const std::vector<Edge> &edges = mBuild[order[i]].edges;
+			for (size_t e = 0; e < edges.size(); e++) {
+				if (newId[edges[e].second] == -1) {
+					newId[edges[e].second] = (int)order.size();
+					order.push_back(edges[e].second);
+				}
+			}
+		}
+
+		mFinal.assign(order.size(), 0);
+		mFirstEdge.assign(order.size() + 1, 0);
+		for (size_t i = 0; i < order.size(); i++) {
+			const BuildState &state = mBuild[order[i]];
+			mFinal[i] = state.final;
+			mFirstEdge[i] = (int)mEdgeChar.size();
+			for (size_t e = 0; e < state.edges.size(); e++) {
+				mEdgeChar.push_back(state.edges[e].first);
+				mEdgeTarget.push_back(newId[state.edges[e].second]);
+			}
+		}
+		mFirstEdge[order.size()] = (int)mEdgeChar.size();
+
+		std::vector<BuildState>().swap(mBuild);
+		std::vector<Unchecked>().swap(mUnchecked);
+		delete mRegister;
+		mRegister = nullptr;
+	}
+
+	/*
+	 * Returns whether word is in the graph
+	 * @param word
+	 * @return bool indicating whether word was added
+	 */
+	bool dawgContains(const string &word) const {
+		int state = 0;
+		for (size_t i = 0; i < word.length(); i++) {
+			state = findEdge(state, word[i]);
+			if (state == -1)
+				return false;
+		}
+
+		return mFinal[state] != 0;
+	}
+
+	/*
+	 * Collects every word within maxDist edits of word whose first fixedPrefix characters
+	 * equal those of word. Results are produced in sorted order
+	 * @param word, maximum distance, number of leading characters that must match, output words
+	 */
+	void dawgSearch(const string &word, int maxDist, int fixedPrefix, std::vector<string> &results) const {
+		int columns = (int)word.length() + 1;
+		std::vector<int> rows((word.length() + maxDist + 2) * columns);
+		for (int j = 0; j < columns; j++)
+			rows[j] = j;
+
+		string path;
+		searchFrom(0, word, maxDist, fixedPrefix, rows, path, results);
+	}
+
+	/*
+	 * Returns the number of words in the graph
+	 * @return number of words
+	 */
+	int dawgSize() const { return mWords; }
+
+	/*
+	 * Returns the number of states in the graph
+	 * @return number of states
+	 */
+	int dawgStates() const { return (int)mFinal.size(); }
+
+	/*
+	 * Returns the number of edges in the graph
+	 * @return number of edges
+	 */
+	int dawgEdges() const { return (int)mEdgeChar.size(); }
+
+	/*
+	 * Returns the number of bytes held by the flattened graph
+	 * @return graph size in bytes
+	 */
+	size_t dawgBytes() const {
+		return mFinal.capacity() + mFirstEdge.capacity() * sizeof(int) + mEdgeChar.capacity() + mEdgeTarget.capacity() * sizeof(int);
+	}
+
+	/*
+	 * Writes the flattened graph to a dictionary image
+	 * @param image writer
+	 */
+	void dawgSave(ImageWriter &out) const {
+		out.writeValue(mWords);
+		out.writeArray(mFinal.data(), mFinal.size());
+		out.writeArray(mFirstEdge.data(), mFirstEdge.size());
+		out.writeArray(mEdgeChar.data(), mEdgeChar.size());
+		out.writeArray(mEdgeTarget.data(), mEdgeTarget.size());
+	}
+
+	/*
+	 * Replaces the graph with a flattened graph read from a dictionary image, so dawgAdd()
+	 * and dawgBuild() are not needed. The graph is left unchanged if the image cannot be read
+	 * @param image reader
+	 * @return bool indicating whether the graph was read
+	 */
+	bool dawgLoad(ImageReader &in) {
+		int words = 0;
+		std::vector<char> final, edgeChar;
+		std::vector<int> firstEdge, edgeTarget;
+		if (!in.readValue(words) || !in.readVector(final) || !in.readVector(firstEdge) || !in.readVector(edgeChar) || !in.readVector(edgeTarget))
+			return false;
+
+		// every state needs an edge range, and every range and target must be in bounds
+		if (final.empty() || firstEdge.size() != final.size() + 1 || edgeChar.size() != edgeTarget.size())
+			return false;
+
+		for (size_t i = 0; i < final.size(); i++) {
+			if (firstEdge[i] < 0 || firstEdge[i] > firstEdge[i + 1] || (size_t)firstEdge[i + 1] > edgeChar.size())
+				return false;
+		}
+
+		for (size_t e = 0; e < edgeTarget.size(); e++) {
+			if (edgeTarget[e] < 0 || edgeTarget[e] >= (int)final.size())
+				return false;
+		}
+
+		mFinal.swap(final);
+		mFirstEdge.swap(firstEdge);
+		mEdgeChar.swap(edgeChar);
+		mEdgeTarget.swap(edgeTarget);
+		mWords = words;
+
+		std::vector<BuildState>().swap(mBuild);
+		std::vector<Unchecked>().swap(mUnchecked);
+		delete mRegister;
+		mRegister = nullptr;
+		return true;
+	}
+
+private:
+	typedef std::pair<char, int> Edge; // (label, target state)
+
+	struct BuildState {
+		BuildState() : final(false) {}
+		bool final;
+		std::vector<Edge> edges; // ascending by label
+	};
+
+	// last edge on the path of the previous word that is not minimized yet
+	struct Unchecked {
+		int parent;
+		int child;
+	};
+
+	/*
+	 * Replaces each unchecked state deeper than depth with its registered equivalent, or
+	 * registers it if it is the first of its kind. Deepest states go first so a state's
+	 * children are already canonical when its signature is taken
+	 * @param depth of shared prefix
+	 */
+	void minimize(size_t depth) {
+		while (mUnchecked.size() > depth) {
+			Unchecked unchecked = mUnchecked.back();
+			mUnchecked.pop_back();
+
+			string key = signature(unchecked.child);
+			int *existing = mRegister->mapGet(key);
+			if (existing)
+				mBuild[unchecked.parent].edges.back().second = *existing;
+			else
+				mRegister->mapPut(key, unchecked.child);
+		}
+	}
+
+	/*
+	 * Serializes the final flag and outgoing edges of a construction state. Two states with
+	 * equal signatures accept the same suffixes
+	 * @param state
+	 * @return signature of state
+	 */
+	string signature(int state) const {
+		const BuildState &build = mBuild[state];
+		string key(1, build.final ? '1' : '0');
+		for (size_t e = 0; e < build.edges.size(); e++) {
+			key.push_back(build.edges[e].first);
+			key.append((const char *)&build.edges[e].second, sizeof(int));
+		}
+
+		return key;
+	}
+
+	/*
+	 * Returns the target of the edge labelled c leaving state, or -1 if there is none
+	 * @return target state or -1
+	 */
+	int findEdge(int state, char c) const {
+		for (int e = mFirstEdge[state]; e < mFirstEdge[state + 1]; e++) {
+			if (mEdgeChar[e] == c)
+				return mEdgeTarget[e];
+		}
+
+		return -1;
+	}
+
+	/*
+	 * Follows every edge leaving state, extending the distance row of the current path by
+	 * the edge label, reporting final states within maxDist and descending while any cell
+	 * of the new row is within maxDist
+	 * @param state, query word, maximum distance, fixed prefix length, row storage, current path, output words
+	 */
+	void searchFrom(int state, const string &word, int maxDist, int fixedPrefix, std::vector<int> &rows, string &path, std::vector<string> &results) const {
+		int depth = (int)path.length();
+		int columns = (int)word.length() + 1;
+		const int *prev = &rows[depth * columns];
+		int *curr = &rows[(depth + 1) * columns];
+
+		for (int e = mFirstEdge[state]; e < mFirstEdge[state + 1]; e++) {
+			char c = mEdgeChar[e];
+			if (depth < fixedPrefix && (depth >= (int)word.length() || c != word[depth]))
+				continue;
+
+			curr[0] = depth + 1;
+			int rowMin = curr[0];
+			for (int j = 1; j < columns; j++) {
+				int min = prev[j - 1] + (word[j - 1] == c ? 0 : 1);
+				if (prev[j] + 1 < min)
+					min = prev[j] + 1;
+
+				if (curr[j - 1] + 1 < min)
+					min = curr[j - 1] + 1;
+
+				curr[j] = min;
+				if (min < rowMin)
+					rowMin = min;
+			}
+
+			path.push_back(c);
+			if (mFinal[mEdgeTarget[e]] && curr[columns - 1] <= maxDist)
+				results.push_back(path);
+
+			if (rowMin <= maxDist)
+				searchFrom(mEdgeTarget[e], word, maxDist, fixedPrefix, rows, path, results);
+			path.erase(path.length() - 1);
+		}
+	}
+
+	// construction data, released by dawgBuild()
+	std::vector<BuildState> mBuild;
+	std::vector<Unchecked> mUnchecked; // path of the previous word
+	FlatHashMap<string, int> *mRegister; // signature -> canonical state
+	string mPrevious; // previously added word
+
+	// flattened graph, state 0 is the root
+	std::vector<char> mFinal; // whether each state ends a word
+	std::vector<int> mFirstEdge; // edge range of state i is [mFirstEdge[i], mFirstEdge[i + 1])
+	std::vector<char> mEdgeChar; // label of each edge
+	std::vector<int> mEdgeTarget; // target state of each edge
+	int mWords; // number of words added
+};
@@ -0,0 +1,392 @@
+/*
+ * Alex Li
+ * dictionary header
+ */
+
+#pragma once
+#include "bloomFilter.hpp"
+#include "hashMap.hpp"
+#include "dictionaryImage.hpp"
+#include "imageStream.hpp"
+#include "mappedFile.hpp"
+#include "perfectHashMap.hpp"
+#include <algorithm>
+#include <functional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using std::string;
+using std::string_view;
+
+/*
+ * Loaded dictionary. Words come either from a text word list, hashed into a HashMap whose
+ * keys are views into the memory mapped file, or from a compiled dictionary image that is
+ * queried in place (see dictionaryImage.hpp). Both share the HashMap interface used by the
+ * checkers and suggestion searches. A text dictionary can be frozen once loaded, after which
+ * a minimal perfect hash answers its lookups. Either kind can put a Bloom filter in front
+ * of its lookups, so most misspellings are rejected without touching the table
+ */
+class Dictionary {
+public:
+	/*
+	 * Parameterized Dictionary constructor
+	 * @param initial capacity of the table for a text dictionary
+	 */
+	Dictionary(int capacity) : mTable(capacity), mAttached(false), mFrozen(nullptr), mVersion(0) {}
+
+	/*
+	 * Dictionary destructor, frees the frozen lookup map
+	 */
+	~Dictionary() { delete mFrozen; }
+
+	Dictionary(const Dictionary &) = delete;
+	Dictionary &operator=(const Dictionary &) = delete;
+
+	/*
+	 * Adds a word to the table of a text dictionary, or updates its value, and adds it to
+	 * the filter if there is one. A new word is copied, so key need not outlive the call. An
+	 * attached image and a frozen dictionary are read only, so nothing changes in them. Only
+	 * a new word changes dictionaryVersion, since updating a value leaves the words as they are
+	 * Returns 0 on success and -1 otherwise
+	 * @param key, value
+	 * @return int indicating whether the word was put
+	 */
+	int mapPut(string_view key, int value) {
+		if (mAttached || mFrozen)
+			return -1;
+
+		int *old = mTable.mapGet(key);
+		if (old) {
+			*old = value;
+			return 0;
+		}
+
+		mVersion++;
+		string_view owned = *mOwnedKeys.emplace(key).first;
+		mTable.mapPut(owned, value);
+		if (mFilter.filterEnabled())
+			mFilter.filterAdd(mHash(owned));
+		return 0;
+	}
+
+	/*
+	 * Adds every word of a range to the table of a text dictionary at once, see
+	 * HashMap::mapBulkLoad. The words are not copied and must outlive the dictionary, as
+	 * the lines of a mapped word list do. They are added to the filter if there is one. An
+	 * attached image and a frozen dictionary are read only, so nothing changes in them
+	 * Returns 0 on success and -1 otherwise
+	 * @param range of words, value of every word, whether the words are known to be distinct, thread pool or nullptr
+	 * @return int indicating whether the words were loaded
+	 */
+	template <typename Range>
+	int mapBulkLoad(const Range &keys, int value, bool assumeUnique, ThreadPool *pool = nullptr) {
+		if (mAttached || mFrozen)
+			return -1;
+
+		mVersion++;
+		mTable.mapBulkLoad(keys, value, assumeUnique, pool);
+		if (mFilter.filterEnabled()) {
+			for (auto it = std::begin(keys); it != std::end(keys); ++it)
+				mFilter.filterAdd(mHash(string_view(*it)));
+		}
+		return 0;
+	}
+
+	/*
+	 * Removes a word from the table of a text dictionary, freeing its copy if mapPut made
+	 * one. The filter keeps the word's bits, which only costs a table lookup when it is
+	 * checked. An attached image and a frozen dictionary are read only, so nothing is
+	 * removed from them
+	 * @param key
+	 * @return bool indicating whether the word was removed
+	 */
+	bool mapRemove(string_view key) {
+		if (mAttached || mFrozen || !mTable.mapRemove(key))
+			return false;
+
+		mVersion++;
+		std::set<string, std::less<> >::iterator owned = mOwnedKeys.find(key);
+		if (owned != mOwnedKeys.end())
+			mOwnedKeys.erase(owned);
+		return true;
+	}
+
+	/*
+	 * Attaches a compiled image in place of the table
+	 * Returns 0 on success and -1 otherwise
+	 * @param image contents, which must stay mapped for as long as the dictionary is used
+	 * @return int indicating whether the image was attached
+	 */
+	int dictionaryAttach(string_view contents) {
+		if (mImage.imageOpen(contents) == -1)
+			return -1;
+
+		mAttached = true;
+		mVersion++;
+		return 0;
+	}
+
+	/*
+	 * Builds a PerfectHashMap of the words of a text dictionary that answers mapContains from
+	 * then on, one slot compared per lookup. Lookups get slower and the map takes less memory
+	 * than the table. The table stays for walking the words in chain order; mapPut,
+	 * mapBulkLoad and mapRemove fail afterwards
+	 * Returns 0 on success and -1 otherwise
+	 * @return int indicating whether the dictionary was frozen
+	 */
+	int dictionaryFreeze() {
+		if (mAttached)
+			return -1;
+
+		delete mFrozen;
+		mFrozen = new PerfectHashMap<string_view, int, DictionaryHash>(mTable);
+		if (mFrozen->perfectBuilt())
+			return 0;
+
+		delete mFrozen;
+		mFrozen = nullptr;
+		return -1;
+	}
+
+	/*
+	 * Builds a blocked Bloom filter of every word that mapContains checks first, so a word the
+	 * filter rejects is a miss without a table lookup. Words put later are added to it. The
+	 * false positive rate of bitsPerKey bits per word is BloomFilter::filterRate, and
+	 * BloomFilter::filterBitsForRate gives the bits per word for a rate
+	 * Returns 0 on success and -1 if bitsPerKey is not positive
+	 * @param filter bits per word
+	 * @return int indicating whether the filter was built
+	 */
+	int dictionaryFilter(double bitsPerKey) {
+		if (mFilter.filterInit(mapSize(), bitsPerKey) == -1)
+			return -1;
+
+		mapVisitKeys(0, mapCapacity(), [&](string_view key) { mFilter.filterAdd(mHash(key)); });
+		return 0;
+	}
+
+	/*
+	 * Returns the filter in front of the lookups, or nullptr if there is none
+	 * @return ptr to filter or nullptr
+	 */
+	const BloomFilter* dictionaryFilter() const { return mFilter.filterEnabled() ? &mFilter : nullptr; }
+
+	/*
+	 * Returns the frozen lookup map, or nullptr if the dictionary was not frozen
+	 * @return ptr to frozen map or nullptr
+	 */
+	const PerfectHashMap<string_view, int, DictionaryHash>* dictionaryFrozen() const { return mFrozen; }
+
+	/*
+	 * Returns the attached image, or nullptr for a text dictionary
+	 * @return ptr to image or nullptr
+	 */
+	const DictionaryImage* dictionaryImage() const { return mAttached ? &mImage : nullptr; }
+
+	/*
+	 * Returns whether key is a dictionary word. The key is hashed once, for the filter and
+	 * whichever map answers
+	 * @param key
+	 * @return bool indicating whether key exists in the dictionary
+	 */
+	bool mapContains(string_view key) const {
+		unsigned long long hash = mHash(key);
+		if (mFilter.filterEnabled() && !mFilter.filterMayContain(hash))
+			return false;
+
+		if (mAttached)
+			return mImage.mapContains(key, hash);
+		return mFrozen ? mFrozen->mapContains(key, hash) : mTable.mapContains(key, hash);
+	}
+
+	/*
+	 * Calls visit with every key in the buckets first...last - 1, in chain order
+	 * @param bucket range, visitor taking a string_view
+	 */
+	template <typename Visit>
+	void mapVisitKeys(int first, int last, Visit visit) const {
+		if (mAttached) {
+			mImage.mapVisitKeys(first, last, visit);
+			return;
+		}
+
+		for (int i = first; i < last; i++) {
+			for (HashLink<string_view, int> *link = mTable.mapTableLink(i); link; link = link->getNext())
+				visit(link->getKey());
+		}
+	}
+
+	/*
+	 * Returns a counter that changes whenever words are added, removed or loaded, so caches
+	 * of results derived from the words can tell they are stale
+	 * @return version
+	 */
+	unsigned long long dictionaryVersion() const { return mVersion; }
+
+	/*
+	 * Returns the number of words
+	 * @return number of words
+	 */
+	int mapSize() const { return mAttached ? mImage.mapSize() : mTable.mapSize(); }
+
+	/*
+	 * Returns the number of buckets
+	 * @return number of buckets
+	 */
+	int mapCapacity() const { return mAttached ? mImage.mapCapacity() : mTable.mapCapacity(); }
+
+	/*
+	 * Returns the ratio of (words / buckets)
+	 * @return table load
+	 */
+	double mapTableLoad() const { return (double)mapSize() / (double)mapCapacity(); }
+
+	/*
+	 * Returns the number of buckets without any words
+	 * @return number of empty buckets
+	 */
+	int mapEmptyBuckets() const { return mAttached ? mImage.mapEmptyBuckets() : mTable.mapEmptyBuckets(); }
+
+	/*
+	 * Returns the number of words in the longest bucket chain
+	 * @return max chain length
+	 */
+	int mapMaxChainLength() const { return mAttached ? mImage.mapMaxChainLength() : mTable.mapMaxChainLength(); }
+
+	/*
+	 * Returns the chain shape and, when built with HASHMAP_STATS, the operation counters of
+	 * the table or image in use
+	 * @return stats snapshot
+	 */
+	MapStats mapStats() const { return mAttached ? mImage.mapStats() : mTable.mapStats(); }
+
+	/*
+	 * Writes the table section of an image: the bucket ranges, the links in chain order and
+	 * the pool of their characters. The buckets keep the current capacity, so the image
+	 * hashes exactly like this dictionary
+	 * @param image writer
+	 */
+	void dictionaryWrite(ImageWriter &out) const {
+		std::vector<unsigned int> buckets(1, 0);
+		std::vector<ImageLink> links;
+		string pool;
+		for (int i = 0; i < mapCapacity(); i++) {
+			mapVisitKeys(i, i + 1, [&](string_view key) {
+				ImageLink link = { (unsigned int)pool.length(), (unsigned int)key.length() };
+				links.push_back(link);
+				pool.append(key);
+			});
+			buckets.push_back((unsigned int)links.size());
+		}
+
+		imageStartSection(out, IMAGE_TABLE);
+		out.writeValue(mapCapacity());
+		out.writeValue(mapSize());
+		out.writeArray(buckets.data(), buckets.size());
+		out.writeArray(links.data(), links.size());
+		out.writeArray(pool.data(), pool.length());
+	}
+
+private:
+	std::set<string, std::less<> > mOwnedKeys; // copies of the words added by mapPut, which mTable keys view
+	DictionaryTable mTable; // words of a text dictionary
+	DictionaryImage mImage; // words of a compiled image
+	bool mAttached; // whether mImage is used instead of mTable
+	PerfectHashMap<string_view, int, DictionaryHash> *mFrozen; // answers lookups of a frozen text dictionary, or nullptr
+	BloomFilter mFilter; // rejects most misses before a lookup, disabled unless built
+	DictionaryHash mHash;
+	unsigned long long mVersion; // bumped by every change to the words, see dictionaryVersion
+};
+
+/*
+ * Returns the offset of the first line starting at or after offset
+ * @param file contents, offset
+ * @return offset of a line start, or the length of the contents
+ */
+inline size_t lineStart(string_view contents, size_t offset) {
+	if (offset == 0)
+		return 0;
+
+	size_t newline = contents.find('\n', offset - 1);
+	return newline == string_view::npos ? contents.length() : newline + 1;
+}
+
+/*
+ * Appends the non-empty lines of contents to lines
+ * @param contents made of whole lines, output lines
+ * @return bool indicating whether the appended lines are strictly ascending
+ */
+inline bool splitLines(string_view contents, std::vector<string_view> &lines) {
+	lines.reserve(lines.size() + std::count(contents.begin(), contents.end(), '\n') + 1);
+	bool ascending = true;
+
+	size_t start = 0;
+	while (start < contents.length()) {
+		size_t end = contents.find('\n', start);
+		if (end == string_view::npos)
+			end = contents.length();
+
+		if (end > start) {
+			string_view line = contents.substr(start, end - start);
+			if (!lines.empty() && lines.back().compare(line) >= 0)
+				ascending = false;
+			lines.push_back(line);
+		}
+		start = end + 1;
+	}
+
+	return ascending;
+}
+
+/*
+ * Maps the dictionary file into memory. A compiled image is attached as is; otherwise every
+ * line is added to the hash table as a string_view into the mapping, so no word is copied.
+ * Empty lines are skipped. The lines are split in one pass that also checks whether they
+ * are strictly ascending, as in dictionary.txt; then they are distinct and are bulk loaded
+ * into a table sized once, without duplicate checks. Given a pool, the file is split on
+ * line boundaries into one chunk per thread and both the split and the bulk load run on
+ * the pool; the table is the same as a serial load's. The file must stay open for as long
+ * as the dictionary is used
+ * Returns 0 on success and -1 otherwise
+ * @param dictionary file name (dictionary.txt or a compiled image), ptr to dictionary and file to map into, thread pool or nullptr
+ * @return int indicating whether load was successful
+ */
+inline int loadDictionary(const string &fname, Dictionary *map, MappedFile *file, ThreadPool *pool = nullptr) {
+	if (!file->fileOpen(fname))
+		return -1;
+
+	string_view contents = file->fileContents();
+	if (DictionaryImage::imageDetect(contents))
+		return map->dictionaryAttach(contents);
+
+	int chunks = pool ? pool->poolThreads() : 1;
+	std::vector<std::vector<string_view> > chunkLines(chunks);
+	std::vector<char> chunkAscending(chunks);
+	auto split = [&](int chunk) {
+		size_t first = lineStart(contents, contents.length() * chunk / chunks);
+		size_t last = lineStart(contents, contents.length() * (chunk + 1) / chunks);
+		chunkAscending[chunk] = splitLines(contents.substr(first, last - first), chunkLines[chunk]);
+	};
+
+	if (chunks > 1)
+		pool->poolFor(chunks, split);
+	else
+		split(0);
+
+	// join the chunks, checking the order across their boundaries too
+	std::vector<string_view> &lines = chunkLines[0];
+	bool ascending = chunkAscending[0];
+	for (int chunk = 1; chunk < chunks; chunk++) {
+		const std::vector<string_view> &next = chunkLines[chunk];
+		if (next.empty())
+			continue;
+
+		ascending = ascending && chunkAscending[chunk] && (lines.empty() || lines.back().compare(next.front()) < 0);
+		lines.insert(lines.end(), next.begin(), next.end());
+	}
+
+	map->mapBulkLoad(lines, 1, ascending, pool);
+	return 0;
+}
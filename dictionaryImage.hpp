@@ -0,0 +1,344 @@
+/*
+ * Alex Li
+ * dictionaryImage header
+ */
+
+#pragma once
+#include "hashMap.hpp"
+#include "hashPolicy.h"
+#include "imageStream.hpp"
+#include "mapStats.hpp"
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+using std::string;
+using std::string_view;
+
+#define IMAGE_MAGIC "SPELLIMG"
+#define IMAGE_VERSION 2
+#define IMAGE_ORDER_MARK 0x01020304
+
+// hash policy of the dictionary table. Images are bucketed with it too, so changing it
+// requires a new IMAGE_VERSION. Links come from an arena; keys stay views into the mapped file,
+// or into the copies a Dictionary makes of words added with mapPut
+typedef WyHash DictionaryHash;
+typedef HashMap<string_view, int, DictionaryHash, ArenaAllocator> DictionaryTable;
+
+// sections of a dictionary image, in file order
+enum ImageSection {
+	IMAGE_TABLE, // the dictionary words, always present
+	IMAGE_PARTITIONS, // CandidateIndex
+	IMAGE_SYMSPELL, // SymSpellIndex
+	IMAGE_BKTREE, // BKTree
+	IMAGE_DAWG, // Dawg
+	IMAGE_SECTIONS
+};
+
+// first bytes of every image file
+struct ImageHeader {
+	char magic[8]; // IMAGE_MAGIC without its terminator
+	unsigned int version; // IMAGE_VERSION
+	unsigned int orderMark; // IMAGE_ORDER_MARK as written, rejects images of the other byte order
+	unsigned long long fileBytes; // size of the whole image
+	unsigned long long sectionOffset[IMAGE_SECTIONS]; // from the start of the file, 0 if absent
+	unsigned long long sectionChecksum[IMAGE_SECTIONS]; // DictionaryHash of each section's bytes, 0 if absent
+};
+
+/*
+ * Returns the end of a section: the start of the next section in the file, or the end of
+ * the file for the last one
+ * @param image header, present section
+ * @return offset just past the section
+ */
+inline unsigned long long imageSectionEnd(const ImageHeader &header, int section) {
+	unsigned long long end = header.fileBytes;
+	for (int s = 0; s < IMAGE_SECTIONS; s++) {
+		if (header.sectionOffset[s] > header.sectionOffset[section] && header.sectionOffset[s] < end)
+			end = header.sectionOffset[s];
+	}
+	return end;
+}
+
+// dictionary word in an image, a range of the image's character pool
+struct ImageLink {
+	unsigned int offset;
+	unsigned int length;
+};
+
+/*
+ * Read only view of a dictionary image. The table section lays the hash table out as
+ * arrays: bucket i holds the links [buckets[i], buckets[i + 1]) in chain order, and every
+ * link is a range of one character pool. Lookups hash and compare keys directly in the
+ * mapped file, so attaching an image parses and rehashes nothing. Values are not stored;
+ * every dictionary word maps to 1. Each section has its own checksum, checked when the
+ * section is first used, so only the pages of the sections in use are read
+ */
+class DictionaryImage {
+public:
+	/*
+	 * Default DictionaryImage constructor, no image is attached
+	 */
+	DictionaryImage() : mBuckets(nullptr), mLinks(nullptr), mPool(nullptr), mCapacity(0), mSize(0) {}
+
+	/*
+	 * Returns whether the contents start like a dictionary image rather than a word list
+	 * @param file contents
+	 * @return bool indicating whether contents has the image magic
+	 */
+	static bool imageDetect(string_view contents) {
+		return contents.length() >= sizeof(ImageHeader) && contents.compare(0, strlen(IMAGE_MAGIC), IMAGE_MAGIC) == 0;
+	}
+
+	/*
+	 * Attaches an image after checking its header and table section. The contents
+	 * must stay mapped for as long as the image is used
+	 * Returns 0 on success and -1 otherwise
+	 * @param file contents
+	 * @return int indicating whether the image was attached
+	 */
+	int imageOpen(string_view contents) {
+		if (!imageDetect(contents))
+			return -1;
+
+		ImageHeader header;
+		memcpy(&header, contents.data(), sizeof(ImageHeader));
+		if (header.version != IMAGE_VERSION || header.orderMark != IMAGE_ORDER_MARK || header.fileBytes != contents.length())
+			return -1;
+
+		for (int s = 0; s < IMAGE_SECTIONS; s++) {
+			if (header.sectionOffset[s] % IMAGE_ALIGNMENT != 0 || header.sectionOffset[s] > header.fileBytes)
+				return -1;
+		}
+
+		if (header.sectionOffset[IMAGE_TABLE] == 0 || !sectionValid(contents, header, IMAGE_TABLE))
+			return -1;
+
+		ImageReader reader(sectionBytes(contents, header, IMAGE_TABLE));
+		size_t buckets = 0, links = 0, pool = 0;
+		int capacity = 0, size = 0;
+		if (!reader.readValue(capacity) || !reader.readValue(size))
+			return -1;
+
+		const unsigned int *bucketArray = reader.readArray<unsigned int>(buckets);
+		const ImageLink *linkArray = reader.readArray<ImageLink>(links);
+		const char *poolArray = reader.readArray<char>(pool);
+		if (!poolArray || capacity <= 0 || buckets != (size_t)capacity + 1 || links != (size_t)size)
+			return -1;
+
+		// bucket ranges must be ascending and cover every link, links must lie in the pool
+		if (bucketArray[0] != 0 || bucketArray[capacity] != links)
+			return -1;
+
+		for (int i = 0; i < capacity; i++) {
+			if (bucketArray[i] > bucketArray[i + 1])
+				return -1;
+		}
+
+		for (size_t i = 0; i < links; i++) {
+			if (linkArray[i].offset > pool || linkArray[i].length > pool - linkArray[i].offset)
+				return -1;
+		}
+
+		mContents = contents;
+		memcpy(&mHeader, &header, sizeof(ImageHeader));
+		mBuckets = bucketArray;
+		mLinks = linkArray;
+		mPool = poolArray;
+		mCapacity = capacity;
+		mSize = size;
+		return 0;
+	}
+
+	/*
+	 * Returns a reader over the bytes of a section, after checking the section's checksum
+	 * @param section, output reader
+	 * @return bool indicating whether the image has the section and it is intact
+	 */
+	bool imageSection(ImageSection section, ImageReader &reader) const {
+		if (!mBuckets || mHeader.sectionOffset[section] == 0 || !sectionValid(mContents, mHeader, section))
+			return false;
+
+		reader = ImageReader(sectionBytes(mContents, mHeader, section));
+		return true;
+	}
+
+	/*
+	 * Returns whether key is a word of the image
+	 * @param key
+	 * @return bool indicating whether key exists in the image
+	 */
+	bool mapContains(string_view key) const { return mapContains(key, mHash(key)); }
+
+	/*
+	 * mapContains for a key whose DictionaryHash the caller already has
+	 * @param key, DictionaryHash of key
+	 * @return bool indicating whether key exists in the image
+	 */
+	bool mapContains(string_view key, unsigned long long hash) const {
+		int index = (int)(hash % (unsigned long long)mCapacity);
+		for (unsigned int i = mBuckets[index]; i < mBuckets[index + 1]; i++) {
+			if (linkKey(i).compare(key) == 0) {
+				MAP_STAT(mCounters.countLookup(i - mBuckets[index] + 1, true));
+				return true;
+			}
+		}
+
+		MAP_STAT(mCounters.countLookup(mBuckets[index + 1] - mBuckets[index], false));
+		return false;
+	}
+
+	/*
+	 * Calls visit with every key in the buckets first...last - 1, in chain order
+	 * @param bucket range, visitor taking a string_view
+	 */
+	template <typename Visit>
+	void mapVisitKeys(int first, int last, Visit visit) const {
+		for (unsigned int i = mBuckets[first]; i < mBuckets[last]; i++)
+			visit(linkKey(i));
+	}
+
+	/*
+	 * Returns the number of words in the image
+	 * @return number of words
+	 */
+	int mapSize() const { return mSize; }
+
+	/*
+	 * Returns number of buckets in the image
+	 * @return number of buckets
+	 */
+	int mapCapacity() const { return mCapacity; }
+
+	/*
+	 * Returns the number of buckets without any links
+	 * @return number of empty buckets
+	 */
+	int mapEmptyBuckets() const {
+		int empty = 0;
+		for (int i = 0; i < mCapacity; i++) {
+			if (mBuckets[i] == mBuckets[i + 1])
+				empty++;
+		}
+
+		return empty;
+	}
+
+	/*
+	 * Returns the number of links in the longest bucket chain
+	 * @return max chain length
+	 */
+	int mapMaxChainLength() const {
+		unsigned int longest = 0;
+		for (int i = 0; i < mCapacity; i++) {
+			if (mBuckets[i + 1] - mBuckets[i] > longest)
+				longest = mBuckets[i + 1] - mBuckets[i];
+		}
+
+		return (int)longest;
+	}
+
+	/*
+	 * Returns the chain shape of the image and, when built with HASHMAP_STATS, its lookup
+	 * counters (see mapStats.hpp)
+	 * @return stats snapshot
+	 */
+	MapStats mapStats() const {
+		std::vector<int> histogram(1, 0);
+		for (int i = 0; i < mCapacity; i++) {
+			int length = (int)(mBuckets[i + 1] - mBuckets[i]);
+			if (length >= (int)histogram.size())
+				histogram.resize(length + 1, 0);
+			histogram[length]++;
+		}
+
+		MapStats stats;
+		statsShape(stats, histogram, mSize, mCapacity);
+		MAP_STAT(mCounters.countersReport(stats));
+		return stats;
+	}
+
+	/*
+	 * Returns the size of the attached image
+	 * @return image size in bytes
+	 */
+	size_t imageBytes() const { return mContents.length(); }
+
+private:
+	/*
+	 * Returns the key of a link
+	 * @param link index
+	 * @return view of the key in the pool
+	 */
+	string_view linkKey(unsigned int link) const { return string_view(mPool + mLinks[link].offset, mLinks[link].length); }
+
+	/*
+	 * Returns the bytes of a present section
+	 * @param image contents, header, section
+	 * @return section bytes
+	 */
+	static string_view sectionBytes(string_view contents, const ImageHeader &header, int section) {
+		unsigned long long offset = header.sectionOffset[section];
+		return contents.substr(offset, imageSectionEnd(header, section) - offset);
+	}
+
+	/*
+	 * Returns whether the bytes of a present section match its checksum
+	 * @param image contents, header, section
+	 * @return bool indicating whether the section is intact
+	 */
+	bool sectionValid(string_view contents, const ImageHeader &header, int section) const {
+		return mHash(sectionBytes(contents, header, section)) == header.sectionChecksum[section];
+	}
+
+	DictionaryHash mHash;
+	string_view mContents; // the whole mapped image
+	ImageHeader mHeader;
+	const unsigned int *mBuckets; // capacity + 1 link indexes
+	const ImageLink *mLinks;
+	const char *mPool; // all keys back to back
+	int mCapacity; // number of buckets
+	int mSize; // number of links
+	MAP_STAT(mutable MapCounters mCounters;) // lookup counters, see mapStats.hpp
+};
+
+/*
+ * Starts an image: writes a header to be completed by imageFinish()
+ * @param image writer, which must be empty
+ */
+inline void imageStart(ImageWriter &out) {
+	ImageHeader header;
+	memset(&header, 0, sizeof(ImageHeader));
+	out.writeValue(header);
+}
+
+/*
+ * Records that the next bytes written form the given section
+ * @param image writer, section
+ */
+inline void imageStartSection(ImageWriter &out, ImageSection section) {
+	out.writeAt(offsetof(ImageHeader, sectionOffset) + section * sizeof(unsigned long long), (unsigned long long)out.writerOffset());
+}
+
+/*
+ * Completes the header once every section is written: magic, version, size and the checksum
+ * of every section
+ * @param image writer
+ */
+inline void imageFinish(ImageWriter &out) {
+	const std::vector<char> &bytes = out.writerBytes();
+	ImageHeader header;
+	memcpy(&header, bytes.data(), sizeof(ImageHeader));
+	memcpy(header.magic, IMAGE_MAGIC, sizeof(header.magic));
+	header.version = IMAGE_VERSION;
+	header.orderMark = IMAGE_ORDER_MARK;
+	header.fileBytes = bytes.size();
+	for (int s = 0; s < IMAGE_SECTIONS; s++) {
+		if (header.sectionOffset[s] != 0) {
+			unsigned long long end = imageSectionEnd(header, s);
+			header.sectionChecksum[s] = DictionaryHash()(string_view(bytes.data() + header.sectionOffset[s], end - header.sectionOffset[s]));
+		}
+	}
+	out.writeAt(0, header);
+}
@@ -0,0 +1,275 @@
+/*
+ * Alex Li
+ * documentChecker header
+ */
+
+#pragma once
+#include "suggestions.hpp"
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using std::string;
+using std::string_view;
+
+/*
+ * Output stream wrapper that collects text in a large buffer and hands it to the stream
+ * in one write per buffer, instead of one formatted write (and flush) per line
+ */
+class BufferedWriter {
+public:
+	/*
+	 * Parameterized BufferedWriter constructor
+	 * @param output stream, buffer size in bytes
+	 */
+	BufferedWriter(std::ostream &os, size_t capacity = 1 << 16) : mOs(os), mBuffer(capacity), mUsed(0) {}
+
+	/*
+	 * BufferedWriter destructor, flushes whatever is still buffered
+	 */
+	~BufferedWriter() { flush(); }
+
+	/*
+	 * Appends text to the buffer, flushing first if it does not fit
+	 * @param text
+	 */
+	void write(string_view text) {
+		if (mUsed + text.length() > mBuffer.size()) {
+			flush();
+			if (text.length() > mBuffer.size()) {
+				mOs.write(text.data(), text.length());
+				return;
+			}
+		}
+
+		memcpy(&mBuffer[mUsed], text.data(), text.length());
+		mUsed += text.length();
+	}
+
+	/*
+	 * Appends a single character to the buffer
+	 * @param c
+	 */
+	void write(char c) { write(string_view(&c, 1)); }
+
+	/*
+	 * Appends the decimal digits of n to the buffer
+	 * @param n
+	 */
+	void writeNumber(unsigned long long n) {
+		char digits[20];
+		int i = sizeof(digits);
+		do {
+			digits[--i] = (char)('0' + n % 10);
+			n /= 10;
+		} while (n != 0);
+
+		write(string_view(digits + i, sizeof(digits) - i));
+	}
+
+	/*
+	 * Writes the buffered text to the stream
+	 */
+	void flush() {
+		if (mUsed != 0)
+			mOs.write(&mBuffer[0], mUsed);
+		mUsed = 0;
+	}
+
+private:
+	std::ostream &mOs;
+	std::vector<char> mBuffer;
+	size_t mUsed; // bytes buffered
+};
+
+/*
+ * Splits a stream into words without copying them. The stream is read in large blocks and
+ * every token is a string_view into the current block, valid until the next call to next().
+ * A word is a run of ASCII letters, optionally joined by apostrophes (don't, i'm). A word
+ * cut off by the end of a block is moved to the front of the buffer before the next block
+ * is read behind it. A tokenizer over text already in memory reads it in place, and its
+ * tokens stay valid for as long as the text.
+ */
+class Tokenizer {
+public:
+	/*
+	 * Parameterized Tokenizer constructor
+	 * @param input stream, block size in bytes
+	 */
+	Tokenizer(std::istream &is, size_t capacity = 1 << 20) : mIs(&is), mBuffer(capacity), mData(mBuffer.data()), mBegin(0), mEnd(0), mBase(0), mEof(false) {}
+
+	/*
+	 * Parameterized Tokenizer constructor for text in memory, which is not copied
+	 * @param text, which must outlive the tokens
+	 */
+	Tokenizer(string_view text) : mIs(nullptr), mData(text.data()), mBegin(0), mEnd(text.length()), mBase(0), mEof(true) {}
+
+	/*
+	 * Finds the next word in the stream
+	 * @param output word, output byte offset of the word in the stream
+	 * @return false once the stream has no more words
+	 */
+	bool next(string_view &token, unsigned long long &offset) {
+		// skip everything up to the first letter
+		while (true) {
+			while (mBegin < mEnd && !isLetter(mData[mBegin]))
+				mBegin++;
+
+			if (mBegin < mEnd)
+				break;
+
+			if (!refill())
+				return false;
+		}
+
+		size_t end = mBegin + 1;
+		while (true) {
+			if (end == mEnd) {
+				size_t length = end - mBegin;
+				bool more = refill();
+				end = mBegin + length;
+				if (!more)
+					break;
+				continue;
+			}
+
+			if (isLetter(mData[end])) {
+				end++;
+				continue;
+			}
+
+			// an apostrophe belongs to the word only when a letter follows it
+			if (mData[end] == '\'') {
+				if (end + 1 == mEnd) {
+					size_t length = end - mBegin;
+					bool more = refill();
+					end = mBegin + length;
+					if (!more)
+						break;
+					continue;
+				}
+
+				if (isLetter(mData[end + 1])) {
+					end += 2;
+					continue;
+				}
+			}
+			break;
+		}
+
+		token = string_view(mData + mBegin, end - mBegin);
+		offset = mBase + mBegin;
+		mBegin = end;
+		return true;
+	}
+
+private:
+	static bool isLetter(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+
+	/*
+	 * Moves the unconsumed bytes to the front of the buffer and reads the next block behind
+	 * them, growing the buffer if a single word fills it
+	 * @return false if the stream had no more bytes
+	 */
+	bool refill() {
+		if (mEof)
+			return false;
+
+		size_t keep = mEnd - mBegin;
+		if (keep == mBuffer.size()) {
+			mBuffer.resize(mBuffer.size() * 2);
+			mData = mBuffer.data();
+		}
+
+		memmove(&mBuffer[0], &mBuffer[mBegin], keep);
+		mBase += mBegin;
+		mBegin = 0;
+		mEnd = keep;
+
+		mIs->read(&mBuffer[mEnd], mBuffer.size() - mEnd);
+		size_t got = (size_t)mIs->gcount();
+		mEnd += got;
+		if (got == 0)
+			mEof = true;
+
+		return got != 0;
+	}
+
+	std::istream *mIs; // stream read in blocks, nullptr for text in memory
+	std::vector<char> mBuffer;
+	const char *mData; // bytes tokenized, mBuffer or the text in memory
+	size_t mBegin; // first unconsumed byte
+	size_t mEnd; // end of valid bytes
+	unsigned long long mBase; // stream offset of mBuffer[0]
+	bool mEof;
+};
+
+// totals of one checkDocument run
+struct CheckStats {
+	unsigned long long words;
+	unsigned long long misspellings;
+};
+
+/*
+ * Copies token into word, lowercased, since the dictionary is lowercase. word keeps its
+ * capacity between calls, so reusing it does not allocate
+ * @param token, output word
+ */
+inline void lowercaseWord(string_view token, string &word) {
+	word.assign(token.data(), token.length());
+	for (size_t i = 0; i < word.length(); i++) {
+		if (word[i] >= 'A' && word[i] <= 'Z')
+			word[i] += 'a' - 'A';
+	}
+}
+
+/*
+ * Writes one misspelling line: byte offset, word and comma separated suggestions,
+ * separated by tabs
+ * @param writer, byte offset, word as it appeared in the document, suggestions
+ */
+inline void writeMisspelling(BufferedWriter &writer, unsigned long long offset, string_view token, const vector<string> &suggestions) {
+	writer.writeNumber(offset);
+	writer.write('\t');
+	writer.write(token);
+	writer.write('\t');
+	for (size_t i = 0; i < suggestions.size(); i++) {
+		if (i != 0)
+			writer.write(',');
+		writer.write(suggestions[i]);
+	}
+	writer.write('\n');
+}
+
+/*
+ * Checks every word of a document against the dictionary. Each misspelling is written as
+ * one line: byte offset, word and comma separated suggestions, separated by tabs. Words
+ * are lowercased before lookup, since the dictionary is lowercase
+ * @param input stream, output stream, ptr to loaded dictionary and suggestion options
+ * @return word and misspelling counts
+ */
+inline CheckStats checkDocument(std::istream &in, std::ostream &out, Dictionary *dictionary, SuggestOptions *options) {
+	CheckStats stats = { 0, 0 };
+	Tokenizer tokenizer(in);
+	BufferedWriter writer(out);
+	string word; // lowercased token, reused so lookups do not allocate
+	vector<string> suggestions;
+
+	string_view token;
+	unsigned long long offset;
+	while (tokenizer.next(token, offset)) {
+		stats.words++;
+		lowercaseWord(token, word);
+		if (dictionary->mapContains(word))
+			continue;
+
+		stats.misspellings++;
+		suggestions.clear();
+		collectSuggestions(dictionary, options, word, suggestions);
+		writeMisspelling(writer, offset, token, suggestions);
+	}
+
+	return stats;
+}
@@ -0,0 +1,208 @@
+/*
+ * Alex Li
+ * editDistance header
+ */
+
+#pragma once
+#include <string>
+#include <string_view>
+
+using std::string;
+using std::string_view;
+
+#define MYERS_MAX_PATTERN 64
+#define SUGGESTION_MAX_DISTANCE 2
+
+// distance kernel signature shared by calcLD, calcLDMyers and calcLDSuggestion. Words are
+// viewed, never copied, so a kernel call makes no allocation
+typedef int (*DistanceFunction)(string_view word1, string_view word2);
+
+/*
+ * Calculates the Levenshtein distance between two words by filling the full
+ * (word1Len + 1) x (word2Len + 1) dynamic programming matrix
+ * @param word1, word2
+ * @return edit distance between the words
+ */
+inline int calcLD(string_view word1, string_view word2) {
+	int word1Len = word1.length();
+	int word2Len = word2.length();
+
+	if (word1Len == 0)
+		return word2Len;
+
+	if (word2Len == 0)
+		return word1Len;
+
+	// construct matrix containing 0...word1Len + 1 rows and 0...word2Len + 1 columns
+	int matrix[word1Len + 1][word2Len + 1];
+
+	// initialize first column to 0...word1Len
+	for (int i = 0; i <= word1Len; i++)
+		matrix[i][0] = i;
+
+	// initialize first row to 0...word2Len
+	for (int i = 0; i <= word2Len; i++)
+		matrix[0][i] = i;
+
+	// examine each character of word1
+	for (int i = 1; i <= word1Len; i++) {
+		char c1 = word1[i - 1];
+
+		// examine each character of word2
+		for (int j = 1; j <= word2Len; j++) {
+			char c2 = word2[j - 1];
+
+			if (c1 == c2)
+				matrix[i][j] = matrix[i - 1][j - 1];
+
+			else {
+				int deletion = matrix[i - 1][j] + 1;
+				int insert = matrix[i][j - 1] + 1;
+				int sub = matrix[i-1][j - 1] + 1;
+				
+				int min = deletion;
+				if (insert < min)
+					min = insert;
+
+				if (sub < min)
+					min = sub;
+
+				matrix[i][j] = min;
+			}
+		}
+	}
+
+	return matrix[word1Len][word2Len];
+}
+
+/*
+ * Calculates the Levenshtein distance between two words with Myers' bit-parallel algorithm
+ * (in Hyyro's formulation for global distance). One column of the DP matrix is encoded as
+ * vertical +1/-1 delta bit vectors, so each character of the text costs a constant number
+ * of 64-bit word operations. The shorter word is used as the pattern; words longer than
+ * MYERS_MAX_PATTERN fall back to calcLD
+ * @param word1, word2
+ * @return edit distance between the words
+ */
+inline int calcLDMyers(string_view word1, string_view word2) {
+	string_view pattern = word1.length() <= word2.length() ? word1 : word2;
+	string_view text = word1.length() <= word2.length() ? word2 : word1;
+	int patternLen = pattern.length();
+	int textLen = text.length();
+
+	if (patternLen == 0)
+		return textLen;
+
+	if (patternLen > MYERS_MAX_PATTERN)
+		return calcLD(word1, word2);
+
+	// match masks: bit i of peq[c] is set when pattern[i] == c
+	unsigned long long peq[256] = { 0 };
+	for (int i = 0; i < patternLen; i++)
+		peq[(unsigned char)pattern[i]] |= 1ULL << i;
+
+	unsigned long long pv = ~0ULL; // vertical +1 deltas
+	unsigned long long mv = 0; // vertical -1 deltas
+	unsigned long long last = 1ULL << (patternLen - 1);
+	int score = patternLen;
+
+	for (int j = 0; j < textLen; j++) {
+		unsigned long long eq = peq[(unsigned char)text[j]];
+		unsigned long long xv = eq | mv;
+		unsigned long long xh = (((eq & pv) + pv) ^ pv) | eq;
+		unsigned long long ph = mv | ~(xh | pv);
+		unsigned long long mh = pv & xh;
+
+		if (ph & last)
+			score++;
+		else if (mh & last)
+			score--;
+
+		// top row of the matrix is 0...textLen, so a +1 horizontal delta enters at row 0
+		ph = (ph << 1) | 1;
+		mh <<= 1;
+		pv = mh | ~(xv | ph);
+		mv = ph & xv;
+	}
+
+	return score;
+}
+
+/*
+ * Calculates the Levenshtein distance between two words when it is at most maxDist.
+ * Only the diagonal band of cells with |i - j| <= maxDist is evaluated, and the scan
+ * stops as soon as every cell of a row exceeds maxDist, since distances never shrink
+ * further down the matrix. Returns maxDist + 1 for any pair further apart
+ * @param word1, word2, maximum distance of interest
+ * @return edit distance between the words, or maxDist + 1
+ */
+inline int calcLDBounded(string_view word1, string_view word2, int maxDist) {
+	int word1Len = word1.length();
+	int word2Len = word2.length();
+	int outside = maxDist + 1;
+
+	// the distance is at least the difference in length
+	if (word1Len - word2Len > maxDist || word2Len - word1Len > maxDist)
+		return outside;
+
+	if (word1Len == 0)
+		return word2Len;
+
+	if (word2Len == 0)
+		return word1Len;
+
+	// two rolling rows of 0...word2Len + 1 columns; cells outside the band hold maxDist + 1
+	int rowA[word2Len + 1];
+	int rowB[word2Len + 1];
+	int *prev = rowA;
+	int *curr = rowB;
+
+	for (int j = 0; j <= word2Len; j++)
+		prev[j] = j <= maxDist ? j : outside;
+
+	for (int i = 1; i <= word1Len; i++) {
+		char c1 = word1[i - 1];
+		int lo = i - maxDist > 1 ? i - maxDist : 1;
+		int hi = i + maxDist < word2Len ? i + maxDist : word2Len;
+
+		curr[0] = i <= maxDist ? i : outside;
+		curr[lo - 1] = lo == 1 ? curr[0] : outside;
+		int rowMin = curr[lo - 1];
+
+		for (int j = lo; j <= hi; j++) {
+			int min = prev[j - 1] + (c1 == word2[j - 1] ? 0 : 1);
+			if (prev[j] + 1 < min)
+				min = prev[j] + 1;
+
+			if (curr[j - 1] + 1 < min)
+				min = curr[j - 1] + 1;
+
+			curr[j] = min < outside ? min : outside;
+			if (curr[j] < rowMin)
+				rowMin = curr[j];
+		}
+
+		// the cell right of the band is read as prev[j] by the next row
+		if (hi < word2Len)
+			curr[hi + 1] = outside;
+
+		if (rowMin > maxDist)
+			return outside;
+
+		int *temp = prev;
+		prev = curr;
+		curr = temp;
+	}
+
+	return prev[word2Len];
+}
+
+/*
+ * calcLDBounded at the suggestion radius, usable as a DistanceFunction. Returns
+ * SUGGESTION_MAX_DISTANCE + 1 for any pair further apart
+ * @param word1, word2
+ * @return edit distance between the words, or SUGGESTION_MAX_DISTANCE + 1
+ */
+inline int calcLDSuggestion(string_view word1, string_view word2) {
+	return calcLDBounded(word1, word2, SUGGESTION_MAX_DISTANCE);
+}
@@ -0,0 +1,157 @@
+/*
+ * Alex Li
+ * epochReclaimer header
+ */
+
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#define EPOCH_READER_STRIPES 64 // reader counters, spread so readers rarely share a cache line
+
+/*
+ * Epoch based memory reclamation for lock-free readers. A reader brackets every access to
+ * shared nodes with epochEnter()/epochExit(), which only bumps a counter tagged with the
+ * current global epoch. A writer that unlinks a node hands it to epochRetire() instead of
+ * deleting it. The global epoch only advances once no reader is left in the epoch before
+ * the current one, so a node retired in epoch e is freed once the epoch reaches e + 2: every
+ * reader that could still hold a pointer to it has exited by then.
+ *
+ * Reader counters are striped per thread, so readers on different threads write different
+ * cache lines. Only the parity of an epoch is needed to tell its readers apart, since at
+ * most two epochs have active readers at any time.
+ */
+class EpochReclaimer {
+public:
+	/*
+	 * Default EpochReclaimer constructor
+	 */
+	EpochReclaimer() : mEpoch(0) {
+		for (int i = 0; i < EPOCH_READER_STRIPES; i++) {
+			mReaders[i].count[0] = 0;
+			mReaders[i].count[1] = 0;
+		}
+	}
+
+	/*
+	 * EpochReclaimer destructor, frees every retired object. No reader may be active
+	 */
+	~EpochReclaimer() {
+		for (size_t i = 0; i < mRetired.size(); i++)
+			mRetired[i].destroy(mRetired[i].object);
+	}
+
+	/*
+	 * Registers the calling thread as a reader of the current epoch
+	 * @return epoch to pass to epochExit()
+	 */
+	unsigned long long epochEnter() {
+		std::atomic<long long> *counts = mReaders[readerStripe()].count;
+		while (true) {
+			unsigned long long epoch = mEpoch.load();
+			counts[epoch & 1]++;
+
+			// the epoch may have advanced before the count was visible; retry in the new one
+			if (mEpoch.load() == epoch)
+				return epoch;
+			counts[epoch & 1]--;
+		}
+	}
+
+	/*
+	 * Ends a read section started by epochEnter()
+	 * @param epoch returned by epochEnter()
+	 */
+	void epochExit(unsigned long long epoch) { mReaders[readerStripe()].count[epoch & 1]--; }
+
+	/*
+	 * Defers deleting object until no reader can still reach it. The object must already be
+	 * unreachable for new readers
+	 * @param object, function that deletes it
+	 */
+	void epochRetire(void *object, void (*destroy)(void *)) {
+		std::lock_guard<std::mutex> lock(mMutex);
+		Retired retired = { mEpoch.load(), object, destroy };
+		mRetired.push_back(retired);
+		tryAdvance();
+	}
+
+	/*
+	 * Returns the number of retired objects not freed yet
+	 * @return pending objects
+	 */
+	size_t epochPending() {
+		std::lock_guard<std::mutex> lock(mMutex);
+		return mRetired.size();
+	}
+
+	/*
+	 * Deletes an object of type T, for use as the destroy function of epochRetire()
+	 * @param object
+	 */
+	template <typename T>
+	static void destroyObject(void *object) { delete (T *)object; }
+
+private:
+	struct Retired {
+		unsigned long long epoch; // epoch the object was retired in
+		void *object;
+		void (*destroy)(void *);
+	};
+
+	struct alignas(64) ReaderStripe {
+		std::atomic<long long> count[2]; // active readers per epoch parity
+	};
+
+	/*
+	 * Returns the reader stripe of the calling thread, assigned round robin on first use
+	 * @return stripe index
+	 */
+	static int readerStripe() {
+		static std::atomic<int> next(0);
+		static thread_local int stripe = next.fetch_add(1) % EPOCH_READER_STRIPES;
+		return stripe;
+	}
+
+	/*
+	 * Advances the epoch if the previous epoch has no readers left, then frees everything
+	 * retired two or more epochs ago. Called with mMutex held
+	 */
+	void tryAdvance() {
+		unsigned long long epoch = mEpoch.load();
+		for (int i = 0; i < EPOCH_READER_STRIPES; i++) {
+			if (mReaders[i].count[(epoch - 1) & 1] != 0)
+				return;
+		}
+
+		mEpoch.store(epoch + 1);
+
+		size_t kept = 0;
+		for (size_t i = 0; i < mRetired.size(); i++) {
+			if (mRetired[i].epoch + 1 <= epoch)
+				mRetired[i].destroy(mRetired[i].object);
+			else
+				mRetired[kept++] = mRetired[i];
+		}
+		mRetired.resize(kept);
+	}
+
+	ReaderStripe mReaders[EPOCH_READER_STRIPES];
+	std::atomic<unsigned long long> mEpoch; // global epoch
+	std::mutex mMutex; // guards mRetired and epoch advances
+	std::vector<Retired> mRetired; // objects waiting for their readers to leave
+};
+
+/*
+ * Read section guard: enters the epoch on construction and exits on destruction
+ */
+class EpochGuard {
+public:
+	EpochGuard(EpochReclaimer &reclaimer) : mReclaimer(reclaimer), mEpoch(reclaimer.epochEnter()) {}
+	~EpochGuard() { mReclaimer.epochExit(mEpoch); }
+
+private:
+	EpochReclaimer &mReclaimer;
+	unsigned long long mEpoch;
+};
@@ -0,0 +1,278 @@
+/*
+ * Alex Li
+ * flatHashMap header
+ */
+
+#pragma once
+#include "hashPolicy.h"
+#include <iostream>
+#include <string>
+#include <utility>
+
+using std::cout;
+using std::endl;
+using std::string;
+
+#define FLAT_MAX_TABLE_LOAD .875
+
+/*
+ * Open addressing counterpart to HashMap. Keys and values live side by side in one
+ * contiguous slot array and collisions are resolved with Robin Hood linear probing, so a
+ * lookup scans neighbouring slots instead of chasing HashLink pointers through the heap.
+ * Exposes the same mapPut/mapContains/mapGet/mapRemove interface as HashMap. Linear
+ * probing needs a well distributed Hash; the legacy character sums cluster badly here.
+ */
+template <typename K, typename V, typename Hash = WyHash>
+class FlatHashMap {
+public:
+	/*
+	 * Parameterized FlatHashMap constructor. Capacity is rounded up to a power of two
+	 * so the slot index can be taken with a mask instead of a modulo
+	 * @param capacity
+	 */
+	FlatHashMap(int capacity) {
+		mCapacity = roundCapacity(capacity);
+		mSize = 0;
+		mSlots = new Slot[mCapacity]();
+		mProbeLengths = new int[mCapacity]();
+	}
+
+	/*
+	 * FlatHashMap destructor
+	 * Slots are owned by a single array so there are no links to walk
+	 */
+	~FlatHashMap() {
+		delete[] mSlots;
+		delete[] mProbeLengths;
+	}
+
+	FlatHashMap(const FlatHashMap &) = delete;
+	FlatHashMap &operator=(const FlatHashMap &) = delete;
+
+	/*
+	 * Returns a pointer to the value stored with the given key. Returns nullptr if the key
+	 * is not in the table.
+	 * @param key
+	 * @return slot value or nullptr
+	 */
+	V* mapGet(const K &key) {
+		int index = findIndex(key);
+		if (index < 0)
+			return nullptr;
+
+		return &mSlots[index].value;
+	}
+
+	/*
+	 * Updates the value stored with the given key if it already exists in the table.
+	 * Otherwise inserts the key-value pair, displacing entries that sit closer to their
+	 * home slot than the new entry (Robin Hood)
+	 * @param key
+	 * @param value
+	 */
+	void mapPut(const K key, const V value) {
+		// resize table if table load exceeds max threshold (default .875)
+		if (mapTableLoad() >= FLAT_MAX_TABLE_LOAD)
+			resizeTable(mCapacity * 2);
+
+		// update value if key exists in table
+		int index = findIndex(key);
+		if (index >= 0) {
+			mSlots[index].value = value;
+			return;
+		}
+
+		insertSlot(key, value);
+	}
+
+	/*
+	 * Attemps to remove the key-value pair specified by the key parameter from the table.
+	 * Following entries of the same probe run are shifted back one slot, so no tombstones
+	 * are left behind. Returns true if removal was successful and false otherwise
+	 * @param key
+	 * @return bool indicating whether key-value pair removal was successful
+	 */
+	bool mapRemove(const K &key) {
+		int index = findIndex(key);
+		if (index < 0)
+			return false;
+
+		// backward shift every displaced entry that follows the removed slot
+		int next = (index + 1) & (mCapacity - 1);
+		while (mProbeLengths[next] > 1) {
+			mSlots[index] = std::move(mSlots[next]);
+			mProbeLengths[index] = mProbeLengths[next] - 1;
+			index = next;
+			next = (next + 1) & (mCapacity - 1);
+		}
+
+		mSlots[index] = Slot();
+		mProbeLengths[index] = 0;
+		mSize--;
+		return true;
+	}
+
+	/*
+	 * Attemps to locate the key specified by the key parameter in the table.
+	 * Returns true if the key is found in the table and false otherwise
+	 * @param key
+	 * @return bool indicating whether key exists in table
+	 */
+	bool mapContains(const K &key) const { return findIndex(key) >= 0; }
+
+	/*
+	 * Returns the number of entries in the table
+	 * @return number of entries
+	 */
+	int mapSize() const { return mSize; }
+
+	/*
+	 * Returns number of slots in the table
+	 * @return number of slots
+	 */
+	int mapCapacity() const { return mCapacity; }
+
+	/*
+	 * Returns whether the slot specified by the index holds an entry
+	 * @return bool indicating whether slot is occupied
+	 */
+	bool mapSlotOccupied(int index) const { return mProbeLengths[index] != 0; }
+
+	/*
+	 * Returns the key stored in the slot specified by the index. Only meaningful
+	 * when mapSlotOccupied(index) is true
+	 * @return key of specified slot
+	 */
+	const K& mapSlotKey(int index) const { return mSlots[index].key; }
+
+	/*
+	 * Returns the number of table slots without an entry
+	 * @return number of empty slots
+	 */
+	int mapEmptyBuckets() const { return mCapacity - mSize; }
+
+	/*
+	 * Returns the ratio of (entries / slots) in the table currently
+	 * @return map table load
+	 */
+	double mapTableLoad() const {
+		double entries = (double)mapSize();
+		double slots = (double)mapCapacity();
+		return (entries / slots);
+	}
+
+	/*
+	 * Resizes the table to contain newCapacity number of slots (rounded up to a power of
+	 * two). Entries are moved from the old slot array into the new one without a
+	 * duplicate check, then the old arrays are freed
+	 * @param new capacity (number of slots)
+	 */
+	void resizeTable(int newCapacity) {
+		Slot *oldSlots = mSlots;
+		int *oldProbeLengths = mProbeLengths;
+		int oldCapacity = mCapacity;
+
+		mCapacity = roundCapacity(newCapacity);
+		mSlots = new Slot[mCapacity]();
+		mProbeLengths = new int[mCapacity]();
+
+		mSize = 0;
+		for (int i = 0; i < oldCapacity; i++) {
+			if (oldProbeLengths[i] != 0)
+				insertSlot(std::move(oldSlots[i].key), std::move(oldSlots[i].value));
+		}
+
+		delete[] oldSlots;
+		delete[] oldProbeLengths;
+	}
+
+	/*
+	 * Overload operator << for FlatHashMap print functionality
+	 * Prints the occupied slots in the format Slot n -> (key, value)
+	 * @param output stream os, FlatHashMap map
+	 * @returns output stream containing formatted FlatHashMap contents
+	 */
+	friend std::ostream& operator<<(std::ostream& os, const FlatHashMap<K, V, Hash>& map) {
+		for (int i = 0; i < map.mapCapacity(); i++) {
+			if (map.mapSlotOccupied(i))
+				os << "Slot " << i << " -> (" << map.mSlots[i].key << ", " << map.mSlots[i].value << ")" << endl;
+		}
+		os << endl;
+		return os;
+	}
+
+private:
+	struct Slot {
+		K key;
+		V value;
+	};
+
+	/*
+	 * Returns the smallest power of two that is at least capacity (minimum 8)
+	 * @return rounded capacity
+	 */
+	static int roundCapacity(int capacity) {
+		int rounded = 8;
+		while (rounded < capacity)
+			rounded *= 2;
+
+		return rounded;
+	}
+
+	/*
+	 * Returns the slot index holding key, or -1 if it is not in the table. The probe
+	 * stops as soon as it reaches a slot whose entry is closer to home than the probe
+	 * itself, since Robin Hood ordering guarantees the key cannot be further along
+	 * @return slot index or -1
+	 */
+	int findIndex(const K &key) const {
+		int index = (int)(mHash(key) & (mCapacity - 1));
+		int probeLength = 1;
+
+		while (mProbeLengths[index] >= probeLength) {
+			if (mProbeLengths[index] == probeLength && mSlots[index].key.compare(key) == 0)
+				return index;
+
+			index = (index + 1) & (mCapacity - 1);
+			probeLength++;
+		}
+
+		return -1;
+	}
+
+	/*
+	 * Inserts a key known not to be in the table. Whenever the carried entry has probed
+	 * further than the resident one, the two are swapped and the resident entry continues
+	 * probing
+	 * @param key
+	 * @param value
+	 */
+	void insertSlot(K key, V value) {
+		int index = (int)(mHash(key) & (mCapacity - 1));
+		int probeLength = 1;
+
+		while (mProbeLengths[index] != 0) {
+			if (mProbeLengths[index] < probeLength) {
+				std::swap(key, mSlots[index].key);
+				std::swap(value, mSlots[index].value);
+				int displaced = mProbeLengths[index];
+				mProbeLengths[index] = probeLength;
+				probeLength = displaced;
+			}
+
+			index = (index + 1) & (mCapacity - 1);
+			probeLength++;
+		}
+
+		mSlots[index].key = std::move(key);
+		mSlots[index].value = std::move(value);
+		mProbeLengths[index] = probeLength;
+		mSize++;
+	}
+
+	Hash mHash;
+	Slot* mSlots;
+	int* mProbeLengths; // probe length + 1 of each slot, 0 when empty
+	int mSize; // number of entries in the table
+	int mCapacity; // number of slots
+};
@@ -4,6 +4,7 @@
  */
 
 #pragma once
+#include <utility>
 
 #ifndef NULL
 #define NULL 0
@@ -12,16 +13,18 @@
 template <typename K, typename V>
 class HashLink {
 public:
-	HashLink(const K &key, const V &value) : mKey(key), mValue(value), next(NULL) {};
-	K getKey() const { return mKey; };
-	V getValue() const { return mValue; };
+	template <typename KeyArg, typename... ValueArgs>
+	HashLink(KeyArg &&key, ValueArgs &&...value) : mKey(std::forward<KeyArg>(key)), mValue(std::forward<ValueArgs>(value)...), next(NULL) {};
+	const K& getKey() const { return mKey; };
+	const V& getValue() const { return mValue; };
+	V& getValue() { return mValue; };
 	HashLink* getNext() const { return next; };
 	void setNext(HashLink* n) { next = n; };
-	void setValue(V value) { mValue = value; };
+	void setValue(const V &value) { mValue = value; };
+	void setValue(V &&value) { mValue = std::move(value); };
 
 private:
 	K mKey;
 	V mValue;
 	HashLink *next;
 };
-
@@ -5,17 +5,33 @@
 
 #pragma once
 #include "hashLink.h"
+#include "hashPolicy.h"
+#include "allocPolicy.h"
+#include "mapStats.hpp"
+#include "threadPool.hpp"
 #include <iostream>
+#include <iterator>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 using std::cout;
 using std::endl;
 using std::string;
+using std::string_view;
 
-#define HASH_FUNCTION hashFunction1
 #define MAX_TABLE_LOAD .75
+#define BULK_PARALLEL_MIN 4096 // fewer keys than this are bulk loaded on the calling thread
+#define MIN_RESIZE_STEP 2 // fewest old buckets moved per operation by an incremental resize
 
-template <typename K, typename V>
+/*
+ * Separate chaining hash table. Hash selects the hash policy (see hashPolicy.h) and Alloc
+ * the allocator policy for links and keys (see allocPolicy.h). The table grows all at once
+ * by default, or a few buckets per operation after mapIncrementalResize()
+ */
+template <typename K, typename V, typename Hash = WyHash, typename Alloc = HeapAllocator>
 class HashMap {
 public:
 	/*
@@ -28,91 +44,83 @@ public:
 		mTable = new HashLink<K, V> *[capacity]();
 		for (int i = 0; i < capacity; i++)		
 			mTable[i] = nullptr;
+
+		mOldTable = nullptr;
+		mOldCapacity = 0;
+		mMigrated = 0;
+		mResizeStep = 0;
 	}
 
 	/*
 	 * HashMap destructor
-	 * Frees link pointers in buckets and delete table
+	 * Frees link pointers in buckets and delete table. Links are not walked when the
+	 * allocator releases them all at once and they have nothing to destroy
 	 */
 	~HashMap() { 
-		HashLink<K, V> *temp, *next;
-
-		// free all links in each bucket
-		for (int i = 0; i < mCapacity; i++) {
-			temp = mTable[i];
-			while (temp != nullptr) {
-				next = temp->getNext();
-				delete temp;
-				temp = next;
-			}
+		if (!Alloc::releasesAll || !std::is_trivially_destructible<HashLink<K, V> >::value) {
+			hashMapCleanup(mTable, mCapacity);
+			if (mOldTable)
+				hashMapCleanup(mOldTable, mOldCapacity);
 		}
 		delete[] mTable;
+		delete[] mOldTable;
 	}
 
 	/*
 	 * Returns a pointer to the value of the link with the given key. Returns nullptr if no 
-	 * link with the given key is in the table.
+	 * link with the given key is in the table. Like every lookup, the key may be a K or any
+	 * string-like type comparable with K (such as string_view or const char *), and no
+	 * temporary K is built from it
 	 * @param key 
 	 * @return link value or nullptr 
 	 */
-	V* mapGet(const K &key) {
-		// get index of bucket
-		int index = HASH_FUNCTION(key) % mapCapacity();
-		if (index < 0)
-			index += mapCapacity();
-
-		HashLink<K, V> *temp = mTable[index];
-		while (temp != nullptr) {
-			if (temp->getKey().compare(key) == 0) {
-				V tempVal = temp->getValue();
-				return &tempVal;
-			}
-
-			temp = temp->getNext();
-		}
-		return nullptr;
+	template <typename Key>
+	V* mapGet(const Key &key) {
+		HashLink<K, V> *link = findLink(lookupKey(key), mHash(lookupKey(key)));
+		return link ? &link->getValue() : nullptr;
 	}
 
 	/*
 	 * Updates the given key-value pair in the hash table if a link with the given key
 	 * already exists. Otherwise allocates a new link with the given key-value pair and adds it
-	 * to the corresponding bucket's linked list.
+	 * to the corresponding bucket's linked list. The key and the value are each moved into
+	 * the link when passed as temporaries and copied otherwise; a key of another type is
+	 * converted to K first
 	 * @param key 
 	 * @param value 
 	 */
-	void mapPut(const K key, const V value) {
-		// resize table if table load exceeds max threshold (default .75)
-		if (mapTableLoad() >= MAX_TABLE_LOAD)
-			resizeTable(mCapacity * 2);
+	template <typename KeyArg, typename ValueArg>
+	void mapPut(KeyArg &&key, ValueArg &&value) {
+		if constexpr (std::is_same<typename std::decay<KeyArg>::type, K>::value)
+			putLink(std::forward<KeyArg>(key), std::forward<ValueArg>(value));
+		else
+			putLink(K(std::forward<KeyArg>(key)), std::forward<ValueArg>(value));
+	}
 
-		// get index of bucket
-		int index = HASH_FUNCTION(key) % mapCapacity();
-		if (index < 0)
-			index += mCapacity;
-
-		// update link value if key exists in table
-		if (mapContains(key)) {
-			HashLink<K, V> *entry = mTable[index];
-			entry->setValue(value);
+	/*
+	 * Adds a link whose value is constructed in place from args, unless a link with the
+	 * given key already exists, in which case nothing is constructed or changed
+	 * @param key, value constructor arguments
+	 * @return bool indicating whether a link was added
+	 */
+	template <typename KeyArg, typename... Args>
+	bool mapEmplace(KeyArg &&key, Args &&...args) {
+		MAP_STAT(mCounters.countPuts(1));
+		growStep();
+		unsigned long long hash = mHash(lookupKey(key));
+		if (findOldLink(lookupKey(key), hash))
+			return false;
+
+		int index = hashIndex(hash, mCapacity);
+		HashLink<K, V> *tail = nullptr;
+		for (HashLink<K, V> *temp = mTable[index]; temp != nullptr; temp = temp->getNext()) {
+			if (temp->getKey().compare(lookupKey(key)) == 0)
+				return false;
+			tail = temp;
 		}
 
-		// otherwise add new link to bucket
-		else {
-			HashLink<K, V> *newLink = new HashLink<K, V> (key, value);
-
-			if (!mTable[index]) 
-				mTable[index] = newLink;
-
-			else {
-				// add new link to end of bucket
-				HashLink<K, V> *temp = mTable[index];
-				while (temp->getNext() != nullptr) 
-					temp = temp->getNext();
-
-				temp->setNext(newLink);
-			}
-			mSize++;
-		}
+		appendLink(index, tail, mAlloc.template allocLink<HashLink<K, V> >(mAlloc.storeKey(K(std::forward<KeyArg>(key))), std::forward<Args>(args)...));
+		return true;
 	}
 
 	/*
@@ -121,33 +129,20 @@ public:
 	 * @param key 
 	 * @return bool indicating whether key-value pair removal was successful
 	 */
-	bool mapRemove(const K &key) {
-		if (mapContains(key)) {
-			int index = HASH_FUNCTION(key) % mapCapacity();
-			if (index < 0)
-				index += mCapacity;
-
-			HashLink<K, V> *temp = mTable[index];
-			HashLink<K, V> *prev = nullptr;
-			while (temp != nullptr) {
-				if (temp->getKey().compare(key) == 0) {
-					if (prev)
-						prev->setNext(temp->getNext());
-
-					mTable[index] = temp->getNext();
-					delete temp;
-					mSize--;
-					return true;
-				}
-
-				else {
-					prev = temp;
-					temp = temp->getNext();
-				}
-			}
+	template <typename Key>
+	bool mapRemove(const Key &key) {
+		MAP_STAT(mCounters.countRemove());
+		if (mOldTable)
+			migrateBuckets(mResizeStep);
+
+		// a key not migrated yet is still in its old bucket
+		if (mOldTable) {
+			int oldIndex = bucketIndex(lookupKey(key), mOldCapacity);
+			if (oldIndex >= mMigrated && removeLink(mOldTable, oldIndex, lookupKey(key)))
+				return true;
 		}
 
-		return false;
+		return removeLink(mTable, bucketIndex(lookupKey(key)), lookupKey(key));
 	}
 
 	/*
@@ -156,21 +151,17 @@ public:
 	 * @param key 
 	 * @return bool indicating whether key exists in table
 	 */
-	bool mapContains(const K &key) {
-		int index = HASH_FUNCTION(key) % mapCapacity();
-		if (index < 0)
-			index += mCapacity;
-
-		HashLink<K, V> *temp = mTable[index];
-		while (temp != nullptr) {
-			if (temp->getKey().compare(key) == 0)
-				return true;
-
-			temp = temp->getNext();
-		}
+	template <typename Key>
+	bool mapContains(const Key &key) const { return findLink(lookupKey(key), mHash(lookupKey(key))) != nullptr; }
 
-		return false;
-	}
+	/*
+	 * mapContains for a key whose policy hash the caller already has, such as a filter in
+	 * front of the table, so the key is not hashed twice
+	 * @param key, Hash of key
+	 * @return bool indicating whether key exists in table
+	 */
+	template <typename Key>
+	bool mapContains(const Key &key, unsigned long long hash) const { return findLink(lookupKey(key), hash) != nullptr; }
 
 	/*
 	 * Returns the number of links in the hash table
@@ -185,7 +176,9 @@ public:
 	int mapCapacity() const { return mCapacity; } 
 
 	/*
-	 * Returns a pointer to the bucket in the table specified by the index
+	 * Returns a pointer to the bucket in the table specified by the index. While an
+	 * incremental resize is in progress some links are still in the old table, so call
+	 * mapFinishResize() before walking every bucket
 	 * @returns HashLink pointer to specified bucket index
 	 */
 	HashLink<K, V>* mapTableLink(int index) const { return mTable[index]; }
@@ -204,6 +197,32 @@ public:
 		return empty;
 	}
 
+	/*
+	 * Selects how the table grows once the load reaches MAX_TABLE_LOAD. With 0, the default,
+	 * every link is rehashed into the larger table at once. Otherwise the old table is kept
+	 * beside the new one and each mapPut, mapEmplace and mapRemove moves the links of only
+	 * bucketsPerOperation old buckets, so no single operation pays for the whole rehash.
+	 * Lookups search the old bucket of a key until it has been moved. Steps below
+	 * MIN_RESIZE_STEP are raised to it: after a doubling from C buckets, 0.75 * C inserts
+	 * reach the next threshold, and the C old buckets must be moved by then, or the next
+	 * doubling moves the rest inside a single insert
+	 * @param old buckets moved per operation, 0 to resize all at once
+	 */
+	void mapIncrementalResize(int bucketsPerOperation) {
+		mResizeStep = bucketsPerOperation > 0 && bucketsPerOperation < MIN_RESIZE_STEP ? MIN_RESIZE_STEP : bucketsPerOperation;
+	}
+
+	/*
+	 * Returns whether an incremental resize is in progress
+	 * @return bool indicating whether links remain in the old table
+	 */
+	bool mapResizing() const { return mOldTable != nullptr; }
+
+	/*
+	 * Moves every link left in the old table, completing an incremental resize
+	 */
+	void mapFinishResize() { migrateBuckets(mOldCapacity); }
+
 	/*
 	 * Returns the ratio of (links / buckets) in the table currently
 	 * @return map table load
@@ -216,7 +235,7 @@ public:
 
 	/*
 	 * Removes all links in the table and frees allocated memory. Used as a helper function
-	 * in the resizeTable() method when the table load exceeds MAP_TABLE_LOAD threshold
+	 * in the destructor
 	 * @param hash table to be cleaned
 	 * @param capacity of table
 	 */
@@ -228,7 +247,7 @@ public:
 			temp = map[i];
 			while (temp != nullptr) {
 				next = temp->getNext();
-				delete temp;
+				mAlloc.freeLink(temp);
 				temp = next;
 			}
 		}
@@ -236,12 +255,17 @@ public:
 
 	/*
 	 * Resizes the hash table to contain newCapacity number of buckets. After the new
-	 * table is allocated, all old links are re-hashed into the new table. The old table
-	 * memory is then deallocated, including all of the old links
+	 * table is allocated, all old links are re-hashed and moved to the end of their new
+	 * bucket, so chains keep their order and no link or key is allocated again. The old
+	 * table memory is then deallocated. An incremental resize in progress is completed first
 	 * @param new capacity (number of buckets)
 	 */
 	void resizeTable(int newCapacity) {
-		// keep reference to old table for copy and delete
+		mapFinishResize();
+		MAP_STAT(mCounters.countResize());
+		MAP_STAT(statsClock::time_point resizeStart = statsClock::now());
+
+		// keep reference to old table for relinking and delete
 		HashLink<K, V> **oldTable = mTable;
 		int oldCapacity = mCapacity;
 		mCapacity = newCapacity;
@@ -252,25 +276,67 @@ public:
 		for (int i = 0; i < newCapacity; i++)		
 			mTable[i] = nullptr;
 
-		// reset size counter and update new size with mapPut()
-		mSize = 0;
-		for (int i = 0; i < oldCapacity; i++) {
-			HashLink<K, V> *temp = oldTable[i];
+		// rehash links from old table into new table
+		for (int i = 0; i < oldCapacity; i++)
+			relinkChain(oldTable[i]);
 
-			// rehash links from old table into new table
-			while (temp != nullptr) {
-				K tempKey = temp->getKey();
-				V tempVal = temp->getValue();
-				mapPut(tempKey, tempVal);
-				temp = temp->getNext();
-			}
+		// free the old table, its links now belong to the new one
+		delete[] oldTable;
+		MAP_STAT(mCounters.countResizeTime(resizeStart));
+	}
+
+	/*
+	 * Grows the table once so that entries links fit without reaching MAX_TABLE_LOAD, so
+	 * inserting up to that many links resizes nothing. The table never shrinks
+	 * @param number of links the table should hold
+	 */
+	void mapReserve(int entries) {
+		int capacity = (int)(entries / MAX_TABLE_LOAD) + 1;
+		if (capacity > mCapacity)
+			resizeTable(capacity);
+	}
+
+	/*
+	 * Adds every key of a sized, random access range with the same value, reserving room for
+	 * all of them first. With assumeUnique the keys must be distinct and not in the table yet:
+	 * each new link is appended to its bucket without looking for an existing link with its
+	 * key. Otherwise every key is put as with mapPut. Given a pool, the keys are hashed and
+	 * linked on all of its threads (see parallelLoad); the table ends up exactly as without one
+	 * @param range of keys, value of every key, whether the keys are known to be new and distinct, thread pool or nullptr
+	 */
+	template <typename Range>
+	void mapBulkLoad(const Range &keys, const V &value, bool assumeUnique, ThreadPool *pool = nullptr) {
+		mapReserve(mSize + (int)std::size(keys));
+		mapFinishResize();
+
+		if (pool && pool->poolThreads() > 1 && std::size(keys) >= BULK_PARALLEL_MIN) {
+			parallelLoad(keys, value, assumeUnique, pool);
+			return;
 		}
 
-		// delete links from old table, set new table capacity, and free the old table
-		hashMapCleanup(oldTable, oldCapacity);
-		delete[] oldTable;
+		for (const auto &key : keys) {
+			if (!assumeUnique) {
+				putLink(key, value);
+				continue;
+			}
+
+			MAP_STAT(mCounters.countPuts(1));
+			int index = bucketIndex(lookupKey(key));
+			HashLink<K, V> *tail = mTable[index];
+			while (tail && tail->getNext() != nullptr)
+				tail = tail->getNext();
+
+			appendLink(index, tail, mAlloc.template allocLink<HashLink<K, V> >(mAlloc.storeKey(key), value));
+		}
 	}
 
+	/*
+	 * Returns the bytes of the arena blocks holding links and keys, 0 when links are
+	 * allocated one by one
+	 * @return allocator bytes
+	 */
+	size_t mapAllocBytes() const { return mAlloc.allocBytes(); }
+
 
 	/*
 	 * Overload operator << for HashMap print functionality
@@ -278,51 +344,372 @@ public:
 	 * @param output stream os, HashMap map
 	 * @returns output stream containing formatted HashMap contents
 	 */
-	friend std::ostream& operator<<(std::ostream& os, const HashMap<K, V>& map) {
-		for (int i = 0; i < map.mapCapacity(); i++) {
-			HashLink<K, V> *entry = map.mTable[i];
-			if (entry != nullptr) {
-				os << "Bucket " << i << " -> ";
-				while (entry != nullptr) {
-					os << "(" << entry->getKey() << ", " << entry->getValue() << ") -> ";
-					entry = entry->getNext();
-				}
-				os << "nullptr";
-				os << endl;
-			}
-		}
+	friend std::ostream& operator<<(std::ostream& os, const HashMap<K, V, Hash, Alloc>& map) {
+		for (int i = 0; i < map.mapCapacity(); i++)
+			printChain(os, "Bucket ", i, map.mTable[i]);
+
+		// links not migrated yet by an incremental resize
+		for (int i = map.mMigrated; map.mOldTable && i < map.mOldCapacity; i++)
+			printChain(os, "Old bucket ", i, map.mOldTable[i]);
 		os << endl;
 		return os;
 	}
 
 	/*
-	 * Hashes the key by folding (summing) each character
-	 * @returns hashed value for input key
+	 * Returns the chain length distribution of the table. Element n of the result is
+	 * the number of buckets holding exactly n links. Only the new table is counted while an
+	 * incremental resize is in progress
+	 * @return chain length histogram
 	 */
-	int hashFunction1(const K &key) {
-		int r = 0;
-		for (int i = 0; key[i] != '\0'; i++)
-			r += key[i];
+	std::vector<int> mapChainHistogram() const {
+		std::vector<int> histogram(1, 0);
+		for (int i = 0; i < mapCapacity(); i++) {
+			int length = 0;
+			for (HashLink<K, V> *temp = mTable[i]; temp != nullptr; temp = temp->getNext())
+				length++;
+
+			if (length >= (int)histogram.size())
+				histogram.resize(length + 1, 0);
+			histogram[length]++;
+		}
 
-		return r;
+		return histogram;
 	}
 
 	/*
-	 * Hashes the key by shifting the value of each character, then folding (summing)
-	 * hashFunction2 prevents anagrams hashing to the same value (via the shift), thus
-	 * resulting in fewer collisions
-	 * @returns hashed value for input key
+	 * Returns the number of links in the longest bucket chain
+	 * @return max chain length
 	 */
-	int hashFunction2(const K &key) {
-		int r = 0;
-		for (int i = 0; key[i] != '\0'; i++)
-			r += (i + 1) * key[i];
+	int mapMaxChainLength() const { return (int)mapChainHistogram().size() - 1; }
 
-		return r;
+	/*
+	 * Returns the chain shape of the table and, when built with HASHMAP_STATS, its operation
+	 * counters: lookups with the links they compared, puts, removes and resizes with the
+	 * time spent rehashing (see mapStats.hpp)
+	 * @return stats snapshot
+	 */
+	MapStats mapStats() const {
+		MapStats stats;
+		statsShape(stats, mapChainHistogram(), mSize, mCapacity);
+		MAP_STAT(mCounters.countersReport(stats));
+		return stats;
 	}
 
 private:
+	/*
+	 * Reduces the policy hash of key to a bucket index
+	 * @return bucket index for input key
+	 */
+	template <typename Key>
+	int bucketIndex(const Key &key) const { return bucketIndex(key, mCapacity); }
+
+	/*
+	 * Reduces the policy hash of key to a bucket index of a table with the given capacity
+	 * @return bucket index for input key
+	 */
+	template <typename Key>
+	int bucketIndex(const Key &key, int capacity) const { return hashIndex(mHash(key), capacity); }
+
+	/*
+	 * Reduces a policy hash to a bucket index of a table with the given capacity
+	 * @return bucket index for the hash
+	 */
+	static int hashIndex(unsigned long long hash, int capacity) { return (int)(hash % (unsigned long long)capacity); }
+
+	/*
+	 * Passes lookup keys through unchanged, except C strings, which are viewed so they can
+	 * be hashed and compared like K
+	 * @return key usable for hashing and comparison
+	 */
+	template <typename Key>
+	static const Key& lookupKey(const Key &key) { return key; }
+	static string_view lookupKey(const char *key) { return string_view(key); }
+
+	/*
+	 * Returns the link with the given key, or nullptr if there is none. Counted lookups
+	 * count the links compared in the current table
+	 * @param lookup key, Hash of key
+	 * @return link or nullptr
+	 */
+	template <typename Key>
+	HashLink<K, V>* findLink(const Key &key, unsigned long long hash) const {
+		HashLink<K, V> *link = findOldLink(key, hash);
+		MAP_STAT(int probes = 0);
+		if (!link) {
+			for (link = mTable[hashIndex(hash, mCapacity)]; link != nullptr; link = link->getNext()) {
+				MAP_STAT(probes++);
+				if (link->getKey().compare(key) == 0)
+					break;
+			}
+		}
+
+		MAP_STAT(mCounters.countLookup(probes, link != nullptr));
+		return link;
+	}
+
+	/*
+	 * Returns the link with the given key if it is still in the old table of an incremental
+	 * resize, or nullptr
+	 * @param lookup key, Hash of key
+	 * @return link or nullptr
+	 */
+	template <typename Key>
+	HashLink<K, V>* findOldLink(const Key &key, unsigned long long hash) const {
+		if (!mOldTable)
+			return nullptr;
+
+		int index = hashIndex(hash, mOldCapacity);
+		if (index < mMigrated)
+			return nullptr;
+
+		for (HashLink<K, V> *temp = mOldTable[index]; temp != nullptr; temp = temp->getNext()) {
+			if (temp->getKey().compare(key) == 0)
+				return temp;
+		}
+
+		return nullptr;
+	}
+
+	/*
+	 * Unlinks and frees the link with the given key from one bucket of a table
+	 * @param table, bucket index, lookup key
+	 * @return bool indicating whether a link was removed
+	 */
+	template <typename Key>
+	bool removeLink(HashLink<K, V> **table, int index, const Key &key) {
+		HashLink<K, V> *temp = table[index];
+		HashLink<K, V> *prev = nullptr;
+		while (temp != nullptr) {
+			if (temp->getKey().compare(key) == 0) {
+				if (prev)
+					prev->setNext(temp->getNext());
+				else
+					table[index] = temp->getNext();
+				mAlloc.freeLink(temp);
+				mSize--;
+				return true;
+			}
+
+			else {
+				prev = temp;
+				temp = temp->getNext();
+			}
+		}
+
+		return false;
+	}
+
+	/*
+	 * Moves every link of a chain to the end of its bucket in the current table
+	 * @param first link of the chain
+	 */
+	void relinkChain(HashLink<K, V> *temp) {
+		while (temp != nullptr) {
+			HashLink<K, V> *next = temp->getNext();
+			temp->setNext(nullptr);
+
+			int index = bucketIndex(temp->getKey());
+			if (!mTable[index])
+				mTable[index] = temp;
+
+			else {
+				HashLink<K, V> *tail = mTable[index];
+				while (tail->getNext() != nullptr)
+					tail = tail->getNext();
+
+				tail->setNext(temp);
+			}
+			temp = next;
+		}
+	}
+
+	/*
+	 * Moves the links of up to count old buckets into the current table, and frees the old
+	 * table once it is empty
+	 * @param number of old buckets to move
+	 */
+	void migrateBuckets(int count) {
+		if (!mOldTable)
+			return;
+		MAP_STAT(statsClock::time_point migrateStart = statsClock::now());
+
+		int end = count < mOldCapacity - mMigrated ? mMigrated + count : mOldCapacity;
+		for (; mMigrated < end; mMigrated++) {
+			relinkChain(mOldTable[mMigrated]);
+			mOldTable[mMigrated] = nullptr;
+		}
+
+		if (mMigrated == mOldCapacity) {
+			delete[] mOldTable;
+			mOldTable = nullptr;
+			mOldCapacity = 0;
+			mMigrated = 0;
+		}
+		MAP_STAT(mCounters.countResizeTime(migrateStart));
+	}
+
+	/*
+	 * Called before every insert: advances an incremental resize, then grows the table if
+	 * the load exceeds MAX_TABLE_LOAD (default .75), all at once or by starting a new
+	 * incremental resize
+	 */
+	void growStep() {
+		if (mOldTable)
+			migrateBuckets(mResizeStep);
+
+		if (mapTableLoad() < MAX_TABLE_LOAD)
+			return;
+
+		if (mResizeStep == 0) {
+			resizeTable(mCapacity * 2);
+			return;
+		}
+
+		mapFinishResize();
+		MAP_STAT(mCounters.countResize());
+		mOldTable = mTable;
+		mOldCapacity = mCapacity;
+		mMigrated = 0;
+		mCapacity *= 2;
+		mTable = new HashLink<K, V> *[mCapacity]();
+	}
+
+	/*
+	 * Prints one chain in the format Bucket n -> (key, value), skipping empty buckets
+	 * @param output stream, bucket label, bucket index, first link of the chain
+	 */
+	static void printChain(std::ostream &os, const char *label, int index, HashLink<K, V> *entry) {
+		if (entry == nullptr)
+			return;
+
+		os << label << index << " -> ";
+		while (entry != nullptr) {
+			os << "(" << entry->getKey() << ", " << entry->getValue() << ") -> ";
+			entry = entry->getNext();
+		}
+		os << "nullptr";
+		os << endl;
+	}
+
+	/*
+	 * Shared by mapPut and mapBulkLoad: updates the value of an existing link, or adds a new
+	 * link, in a single walk of the bucket's chain
+	 * @param key, value
+	 */
+	template <typename KeyArg, typename ValueArg>
+	void putLink(KeyArg &&key, ValueArg &&value) {
+		MAP_STAT(mCounters.countPuts(1));
+		// resize table if table load exceeds max threshold (default .75)
+		growStep();
+
+		// update link value if the key is still in the old table
+		unsigned long long hash = mHash(key);
+		HashLink<K, V> *old = findOldLink(key, hash);
+		if (old) {
+			old->setValue(std::forward<ValueArg>(value));
+			return;
+		}
+
+		// get index of bucket
+		int index = hashIndex(hash, mCapacity);
+
+		// update link value if key exists in table, otherwise remember the end of the bucket
+		HashLink<K, V> *tail = nullptr;
+		for (HashLink<K, V> *temp = mTable[index]; temp != nullptr; temp = temp->getNext()) {
+			if (temp->getKey().compare(key) == 0) {
+				temp->setValue(std::forward<ValueArg>(value));
+				return;
+			}
+			tail = temp;
+		}
+
+		// otherwise add new link to end of bucket
+		appendLink(index, tail, mAlloc.template allocLink<HashLink<K, V> >(mAlloc.storeKey(std::forward<KeyArg>(key)), std::forward<ValueArg>(value)));
+	}
+
+	/*
+	 * Bulk loads keys on every thread of a pool in two passes. First each of n chunks of keys
+	 * hashes its keys and routes them to n partitions, each a contiguous range of buckets.
+	 * Then each partition appends its keys to its own buckets, chunk by chunk, with links
+	 * from an allocator of its own that the table adopts afterwards. No two tasks write the
+	 * same bucket, and every bucket receives its keys in range order, so the chains are the
+	 * ones a serial load builds and nothing is rehashed
+	 * @param range of keys, value of every key, whether the keys are known to be new and distinct, thread pool
+	 */
+	template <typename Range>
+	void parallelLoad(const Range &keys, const V &value, bool assumeUnique, ThreadPool *pool) {
+		int parts = pool->poolThreads();
+		size_t count = std::size(keys);
+		auto first = std::begin(keys);
+
+		// (key position, bucket) pairs of chunk c for partition p, at routed[c * parts + p]
+		std::vector<std::vector<std::pair<int, int> > > routed(parts * parts);
+		pool->poolFor(parts, [&](int chunk) {
+			for (size_t i = count * chunk / parts; i < count * (chunk + 1) / parts; i++) {
+				int index = bucketIndex(lookupKey(first[i]));
+				routed[chunk * parts + (int)((long long)index * parts / mCapacity)].push_back(std::make_pair((int)i, index));
+			}
+		});
+
+		std::vector<Alloc> allocs(parts);
+		std::vector<int> added(parts, 0);
+		pool->poolFor(parts, [&](int part) {
+			for (int chunk = 0; chunk < parts; chunk++) {
+				const std::vector<std::pair<int, int> > &entries = routed[chunk * parts + part];
+				for (size_t e = 0; e < entries.size(); e++) {
+					const auto &key = first[entries[e].first];
+					int index = entries[e].second;
+
+					// update link value if key exists in table, otherwise remember the end of the bucket
+					HashLink<K, V> *tail = nullptr;
+					HashLink<K, V> *temp = mTable[index];
+					for (; temp != nullptr; temp = temp->getNext()) {
+						if (!assumeUnique && temp->getKey().compare(lookupKey(key)) == 0) {
+							temp->setValue(value);
+							break;
+						}
+						tail = temp;
+					}
+					if (temp)
+						continue;
+
+					HashLink<K, V> *newLink = allocs[part].template allocLink<HashLink<K, V> >(allocs[part].storeKey(key), value);
+					if (tail)
+						tail->setNext(newLink);
+					else
+						mTable[index] = newLink;
+					added[part]++;
+				}
+			}
+		});
+
+		for (int part = 0; part < parts; part++) {
+			mAlloc.allocAdopt(allocs[part]);
+			mSize += added[part];
+		}
+		MAP_STAT(mCounters.countPuts(count));
+	}
+
+	/*
+	 * Adds a new link after tail, the last link of the bucket, or as the bucket's first link
+	 * @param bucket index, last link of the bucket or nullptr, new link
+	 */
+	void appendLink(int index, HashLink<K, V> *tail, HashLink<K, V> *newLink) {
+		if (tail)
+			tail->setNext(newLink);
+		else
+			mTable[index] = newLink;
+		mSize++;
+	}
+
+	Hash mHash;
+	Alloc mAlloc;
 	HashLink<K, V>** mTable;
 	int mSize; // number of links in the table
 	int mCapacity; // number of buckets
+	HashLink<K, V>** mOldTable; // table being emptied by an incremental resize, or nullptr
+	int mOldCapacity; // number of buckets in the old table
+	int mMigrated; // old buckets below this index have been moved
+	int mResizeStep; // old buckets moved per operation, 0 to resize all at once
+	MAP_STAT(mutable MapCounters mCounters;) // operation counters, see mapStats.hpp
 };
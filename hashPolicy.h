@@ -0,0 +1,119 @@
+/*
+ * Alex Li
+ * hashPolicy header
+ *
+ * Hash policies for the HashMap family. A policy is a default constructible type whose
+ * operator() maps a key to an unsigned 64-bit hash; the map reduces it to a bucket index.
+ */
+
+#pragma once
+#include <cstring>
+#include <string>
+
+/*
+ * Hashes the key by folding (summing) each character. Anagrams always collide and the
+ * output range is only a few thousand values, so it is kept for comparison only
+ */
+struct HashFunction1 {
+	template <typename K>
+	unsigned long long operator()(const K &key) const {
+		int r = 0;
+		for (size_t i = 0; i < key.length(); i++)
+			r += key[i];
+
+		return (unsigned long long)r;
+	}
+};
+
+/*
+ * Hashes the key by shifting the value of each character, then folding (summing)
+ * hashFunction2 prevents anagrams hashing to the same value (via the shift), thus
+ * resulting in fewer collisions
+ */
+struct HashFunction2 {
+	template <typename K>
+	unsigned long long operator()(const K &key) const {
+		int r = 0;
+		for (size_t i = 0; i < key.length(); i++)
+			r += (i + 1) * key[i];
+
+		return (unsigned long long)r;
+	}
+};
+
+/*
+ * 64-bit FNV-1a. One multiply per byte, well distributed for short keys
+ */
+struct FnvHash {
+	template <typename K>
+	unsigned long long operator()(const K &key) const {
+		unsigned long long r = 14695981039346656037ULL;
+		for (size_t i = 0; i < key.length(); i++) {
+			r ^= (unsigned char)key[i];
+			r *= 1099511628211ULL;
+		}
+
+		return r;
+	}
+};
+
+/*
+ * Multiply-fold hash in the style of wyhash: words are mixed into the state with a
+ * 64x64->128 bit multiply whose halves are xored together. Keys of up to 16 bytes, which
+ * covers nearly every dictionary word, are read with a few overlapping loads and cost
+ * two multiplies in total
+ */
+struct WyHash {
+	template <typename K>
+	unsigned long long operator()(const K &key) const {
+		const unsigned char *p = (const unsigned char *)key.data();
+		size_t len = key.length();
+		unsigned long long seed = 0xa0761d6478bd642fULL;
+		unsigned long long a, b;
+
+		if (len <= 16) {
+			if (len >= 4) {
+				size_t shift = (len >> 3) << 2;
+				a = (read32(p) << 32) | read32(p + shift);
+				b = (read32(p + len - 4) << 32) | read32(p + len - 4 - shift);
+			}
+			else if (len > 0) {
+				a = ((unsigned long long)p[0] << 16) | ((unsigned long long)p[len >> 1] << 8) | p[len - 1];
+				b = 0;
+			}
+			else
+				a = b = 0;
+		}
+
+		else {
+			size_t i = len;
+			while (i > 16) {
+				seed = mix(read64(p) ^ 0xe7037ed1a0b428dbULL, read64(p + 8) ^ seed);
+				p += 16;
+				i -= 16;
+			}
+			a = read64(p + i - 16);
+			b = read64(p + i - 8);
+		}
+
+		return mix(0xe7037ed1a0b428dbULL ^ len, mix(a ^ 0xe7037ed1a0b428dbULL, b ^ seed));
+	}
+
+private:
+	static unsigned long long mix(unsigned long long a, unsigned long long b) {
+		unsigned __int128 r = (unsigned __int128)a * b;
+		return (unsigned long long)r ^ (unsigned long long)(r >> 64);
+	}
+
+	static unsigned long long read32(const unsigned char *p) {
+		unsigned int r;
+		memcpy(&r, p, 4);
+		return r;
+	}
+
+	static unsigned long long read64(const unsigned char *p) {
+		unsigned long long r;
+		memcpy(&r, p, 8);
+		return r;
+	}
+};
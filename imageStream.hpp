@@ -0,0 +1,182 @@
+/*
+ * Alex Li
+ * imageStream header
+ */
+
+#pragma once
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+using std::string;
+using std::string_view;
+
+#define IMAGE_ALIGNMENT 8
+
+/*
+ * Appends values and arrays to the bytes of a binary dictionary image. Each array is
+ * written as its element count followed by its elements, and everything is padded to the
+ * next IMAGE_ALIGNMENT boundary so an array can be used in place once the image is mapped.
+ * Only plain values are written, never pointers, so the image can be mapped at any address
+ */
+class ImageWriter {
+public:
+	/*
+	 * Appends one value
+	 * @param value
+	 */
+	template <typename T>
+	void writeValue(const T &value) { writeBytes(&value, sizeof(T)); }
+
+	/*
+	 * Appends an element count and count elements
+	 * @param pointer to elements, number of elements
+	 */
+	template <typename T>
+	void writeArray(const T *data, size_t count) {
+		writeValue((unsigned long long)count);
+		writeBytes(data, count * sizeof(T));
+	}
+
+	/*
+	 * Overwrites a value written earlier, used to fill in the image header last
+	 * @param byte offset of the value, value
+	 */
+	template <typename T>
+	void writeAt(size_t offset, const T &value) {
+		static_assert(std::is_trivially_copyable<T>::value, "image values must be trivially copyable");
+		memcpy(&mBytes[offset], &value, sizeof(T));
+	}
+
+	/*
+	 * Returns the number of bytes written so far, which is the offset of the next value
+	 * @return image size in bytes
+	 */
+	size_t writerOffset() const { return mBytes.size(); }
+
+	/*
+	 * Returns the bytes written so far
+	 * @return image bytes
+	 */
+	const std::vector<char>& writerBytes() const { return mBytes; }
+
+private:
+	/*
+	 * Appends raw bytes, then pads to the alignment boundary
+	 * @param pointer to bytes, number of bytes
+	 */
+	template <typename T>
+	void writeBytes(const T *data, size_t bytes) {
+		static_assert(std::is_trivially_copyable<T>::value, "image values must be trivially copyable");
+		mBytes.insert(mBytes.end(), (const char *)data, (const char *)data + bytes);
+		mBytes.resize((mBytes.size() + IMAGE_ALIGNMENT - 1) / IMAGE_ALIGNMENT * IMAGE_ALIGNMENT, 0);
+	}
+
+	std::vector<char> mBytes;
+};
+
+/*
+ * Reads back what an ImageWriter wrote, from a view of a mapped image. Every read is
+ * bounds checked; after a failed read the reader stays failed and returns nothing more
+ */
+class ImageReader {
+public:
+	/*
+	 * Default ImageReader constructor, reads nothing
+	 */
+	ImageReader() : mPosition(0), mFailed(true) {}
+
+	/*
+	 * Parameterized ImageReader constructor
+	 * @param view of the bytes to read, which must start on an alignment boundary of the image
+	 */
+	ImageReader(string_view bytes) : mBytes(bytes), mPosition(0), mFailed(false) {}
+
+	/*
+	 * Reads one value
+	 * @param output value
+	 * @return bool indicating whether the value was read
+	 */
+	template <typename T>
+	bool readValue(T &value) {
+		const char *bytes = readBytes(sizeof(T));
+		if (!bytes)
+			return false;
+
+		memcpy(&value, bytes, sizeof(T));
+		return true;
+	}
+
+	/*
+	 * Reads an array in place: the returned elements point into the mapped image
+	 * @param output number of elements
+	 * @return pointer to the first element, or nullptr if the array could not be read
+	 */
+	template <typename T>
+	const T* readArray(size_t &count) {
+		unsigned long long length = 0;
+		if (!readValue(length) || length > (mBytes.length() - mPosition) / sizeof(T)) {
+			mFailed = true;
+			return nullptr;
+		}
+
+		count = (size_t)length;
+		const char *bytes = readBytes(count * sizeof(T));
+		return mFailed ? nullptr : (const T *)bytes;
+	}
+
+	/*
+	 * Reads an array into a vector, replacing its contents
+	 * @param output vector
+	 * @return bool indicating whether the array was read
+	 */
+	template <typename T>
+	bool readVector(std::vector<T> &values) {
+		size_t count = 0;
+		const T *data = readArray<T>(count);
+		if (!data)
+			return false;
+
+		values.assign(data, data + count);
+		return true;
+	}
+
+	/*
+	 * Reads a character array into a string, replacing its contents
+	 * @param output string
+	 * @return bool indicating whether the string was read
+	 */
+	bool readString(string &value) {
+		size_t count = 0;
+		const char *data = readArray<char>(count);
+		if (!data)
+			return false;
+
+		value.assign(data, count);
+		return true;
+	}
+
+private:
+	/*
+	 * Returns the next bytes and advances past them and their padding
+	 * @param number of bytes
+	 * @return pointer to the bytes, or nullptr past the end of the view
+	 */
+	const char* readBytes(size_t bytes) {
+		size_t padded = (bytes + IMAGE_ALIGNMENT - 1) / IMAGE_ALIGNMENT * IMAGE_ALIGNMENT;
+		if (mFailed || padded > mBytes.length() - mPosition) {
+			mFailed = true;
+			return nullptr;
+		}
+
+		const char *data = mBytes.data() + mPosition;
+		mPosition += padded;
+		return data;
+	}
+
+	string_view mBytes;
+	size_t mPosition; // offset of the next value
+	bool mFailed;
+};
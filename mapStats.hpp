@@ -0,0 +1,162 @@
+/*
+ * Alex Li
+ * mapStats header
+ *
+ * Instrumentation for the dictionary hash tables. mapStats() always reports the shape of a
+ * table's chains. Built with HASHMAP_STATS defined (make STATS=1), tables also count their
+ * operations, the links each lookup compares and their resizes; otherwise the counters do
+ * not exist and every MAP_STAT() statement compiles to nothing.
+ */
+
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#define MAP_STATS_PROBE_LIMIT 16 // lookups comparing this many links or more share the last histogram bucket
+
+#ifdef HASHMAP_STATS
+#define MAP_STAT(statement) statement
+#else
+#define MAP_STAT(statement)
+#endif
+
+typedef std::chrono::steady_clock statsClock;
+
+// snapshot returned by mapStats()
+struct MapStats {
+	int size = 0; // number of links
+	int capacity = 0; // number of buckets
+	double load = 0; // links / buckets
+	int emptyBuckets = 0;
+	int maxChain = 0; // links in the longest chain
+	std::vector<int> chainHistogram; // number of buckets by chain length
+
+	// operation counters, all 0 unless counted
+	bool counted = false; // whether the table was built with HASHMAP_STATS
+	unsigned long long puts = 0; // inserts and updates
+	unsigned long long removes = 0;
+	unsigned long long hits = 0; // successful lookups
+	unsigned long long misses = 0; // failed lookups
+	unsigned long long hitProbes = 0; // links compared by all successful lookups
+	unsigned long long missProbes = 0; // links compared by all failed lookups
+	std::vector<unsigned long long> probeHistogram; // lookups by links compared, the last bucket MAP_STATS_PROBE_LIMIT or more
+	unsigned long long resizes = 0; // resizes started, all at once or incremental
+	double resizeSeconds = 0; // time spent rehashing, including incremental steps
+};
+
+/*
+ * Operation counters of one table. The counters are relaxed atomics, since several threads
+ * may look up the same table at once
+ */
+class MapCounters {
+public:
+	/*
+	 * Default MapCounters constructor, every counter starts at 0
+	 */
+	MapCounters() : mPuts(0), mRemoves(0), mHits(0), mMisses(0), mHitProbes(0), mMissProbes(0), mResizes(0), mResizeNanoseconds(0) {
+		for (int i = 0; i <= MAP_STATS_PROBE_LIMIT; i++)
+			mProbeCounts[i] = 0;
+	}
+
+	/*
+	 * Counts one lookup
+	 * @param links compared, whether the key was found
+	 */
+	void countLookup(int probes, bool hit) {
+		(hit ? mHits : mMisses).fetch_add(1, std::memory_order_relaxed);
+		(hit ? mHitProbes : mMissProbes).fetch_add(probes, std::memory_order_relaxed);
+		mProbeCounts[probes < MAP_STATS_PROBE_LIMIT ? probes : MAP_STATS_PROBE_LIMIT].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	/*
+	 * Counts inserts or updates
+	 * @param number of keys put
+	 */
+	void countPuts(unsigned long long count) { mPuts.fetch_add(count, std::memory_order_relaxed); }
+
+	/*
+	 * Counts one remove
+	 */
+	void countRemove() { mRemoves.fetch_add(1, std::memory_order_relaxed); }
+
+	/*
+	 * Counts the start of one resize
+	 */
+	void countResize() { mResizes.fetch_add(1, std::memory_order_relaxed); }
+
+	/*
+	 * Adds the time since start to the rehashing time
+	 * @param start of the rehashing work
+	 */
+	void countResizeTime(statsClock::time_point start) {
+		mResizeNanoseconds.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(statsClock::now() - start).count(), std::memory_order_relaxed);
+	}
+
+	/*
+	 * Copies the counters into a snapshot
+	 * @param output snapshot
+	 */
+	void countersReport(MapStats &stats) const {
+		stats.counted = true;
+		stats.puts = mPuts;
+		stats.removes = mRemoves;
+		stats.hits = mHits;
+		stats.misses = mMisses;
+		stats.hitProbes = mHitProbes;
+		stats.missProbes = mMissProbes;
+		stats.probeHistogram.assign(MAP_STATS_PROBE_LIMIT + 1, 0);
+		for (int i = 0; i <= MAP_STATS_PROBE_LIMIT; i++)
+			stats.probeHistogram[i] = mProbeCounts[i];
+		stats.resizes = mResizes;
+		stats.resizeSeconds = mResizeNanoseconds / 1e9;
+	}
+
+private:
+	std::atomic<unsigned long long> mPuts, mRemoves, mHits, mMisses, mHitProbes, mMissProbes, mResizes, mResizeNanoseconds;
+	std::atomic<unsigned long long> mProbeCounts[MAP_STATS_PROBE_LIMIT + 1];
+};
+
+/*
+ * Fills the chain shape of a snapshot from a chain length histogram
+ * @param output snapshot, buckets by chain length, number of links, number of buckets
+ */
+inline void statsShape(MapStats &stats, const std::vector<int> &histogram, int size, int capacity) {
+	stats.size = size;
+	stats.capacity = capacity;
+	stats.load = capacity ? (double)size / capacity : 0;
+	stats.emptyBuckets = histogram.empty() ? 0 : histogram[0];
+	stats.maxChain = histogram.empty() ? 0 : (int)histogram.size() - 1;
+	stats.chainHistogram = histogram;
+}
+
+/*
+ * Prints a snapshot: the chain shape, then the counters if they were compiled in
+ * @param output stream, snapshot
+ */
+inline void printStats(std::ostream &os, const MapStats &stats) {
+	os << "Table: " << stats.size << " links in " << stats.capacity << " buckets, load " << stats.load << ", ";
+	os << stats.emptyBuckets << " empty buckets, longest chain " << stats.maxChain << std::endl;
+	os << "  chain length:buckets";
+	for (size_t i = 0; i < stats.chainHistogram.size(); i++) {
+		if (stats.chainHistogram[i] != 0)
+			os << " " << i << ":" << stats.chainHistogram[i];
+	}
+	os << std::endl;
+
+	if (!stats.counted) {
+		os << "  operation counters not compiled in, build with make STATS=1" << std::endl;
+		return;
+	}
+
+	os << "  lookups: " << stats.hits << " hits comparing " << (stats.hits ? (double)stats.hitProbes / stats.hits : 0) << " links on average, ";
+	os << stats.misses << " misses comparing " << (stats.misses ? (double)stats.missProbes / stats.misses : 0) << std::endl;
+	os << "  links compared:lookups";
+	for (size_t i = 0; i < stats.probeHistogram.size(); i++) {
+		if (stats.probeHistogram[i] != 0)
+			os << " " << i << (i == MAP_STATS_PROBE_LIMIT ? "+" : "") << ":" << stats.probeHistogram[i];
+	}
+	os << std::endl;
+	os << "  puts: " << stats.puts << ", removes: " << stats.removes << ", resizes: " << stats.resizes << " taking " << stats.resizeSeconds << " s" << std::endl;
+}
@@ -0,0 +1,93 @@
+/*
+ * Alex Li
+ * mappedFile header
+ */
+
+#pragma once
+#include <string>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using std::string;
+using std::string_view;
+
+/*
+ * Read only memory mapping of a whole file. The contents are paged in by the kernel on
+ * first touch and shared with the page cache, so string_views into fileContents() cost no
+ * copy and no allocation. Views stay valid until the file is closed or the MappedFile is
+ * destroyed
+ */
+class MappedFile {
+public:
+	/*
+	 * Default MappedFile constructor, nothing is mapped
+	 */
+	MappedFile() : mData(nullptr), mSize(0) {}
+
+	/*
+	 * MappedFile destructor, unmaps the file
+	 */
+	~MappedFile() { fileClose(); }
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	/*
+	 * Maps the named file, replacing any file mapped before
+	 * @param file name
+	 * @return bool indicating whether the file was opened and mapped
+	 */
+	bool fileOpen(const string &fname) {
+		fileClose();
+		int fd = open(fname.c_str(), O_RDONLY);
+		if (fd == -1)
+			return false;
+
+		struct stat info;
+		if (fstat(fd, &info) == -1) {
+			close(fd);
+			return false;
+		}
+
+		// an empty file cannot be mapped, it is simply empty contents
+		if (info.st_size > 0) {
+			void *data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (data == MAP_FAILED) {
+				close(fd);
+				return false;
+			}
+
+			// the file is read front to back once, then probed at random
+			madvise(data, info.st_size, MADV_WILLNEED);
+			mData = (const char *)data;
+			mSize = info.st_size;
+		}
+
+		// the mapping keeps its own reference to the file
+		close(fd);
+		return true;
+	}
+
+	/*
+	 * Unmaps the file. Views into its contents become invalid
+	 */
+	void fileClose() {
+		if (mData)
+			munmap((void *)mData, mSize);
+		mData = nullptr;
+		mSize = 0;
+	}
+
+	/*
+	 * Returns the whole mapped file
+	 * @return view of the file contents
+	 */
+	string_view fileContents() const { return string_view(mData, mSize); }
+
+private:
+	const char *mData;
+	size_t mSize;
+};
@@ -0,0 +1,111 @@
+/*
+ * Alex Li
+ * misspellingGenerator header
+ */
+
+#pragma once
+#include <random>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+#define MISSPELLING_ALPHABET "abcdefghijklmnopqrstuvwxyz"
+#define MISSPELLING_ATTEMPTS 16 // tries per misspelling before its source word is skipped
+
+// random edits applied to a word, each adds at most 1 to the edit distance
+enum MisspellingEdit {
+	EDIT_INSERT, // a letter inserted anywhere
+	EDIT_DELETE, // one letter removed
+	EDIT_SUBSTITUTE, // one letter replaced by another
+	EDIT_TRANSPOSE, // two adjacent letters swapped
+	EDIT_KINDS
+};
+
+/*
+ * Makes misspellings by applying random edits to dictionary words. Every choice is drawn
+ * straight from a seeded mt19937, whose output the standard fixes, so a seed gives the same
+ * misspellings with any compiler and standard library
+ */
+class MisspellingGenerator {
+public:
+	/*
+	 * Parameterized MisspellingGenerator constructor
+	 * @param seed
+	 */
+	MisspellingGenerator(unsigned int seed) : mRandom(seed) {}
+
+	/*
+	 * Returns word with the given number of random edits applied. The result may be empty
+	 * or another dictionary word
+	 * @param word, number of edits
+	 * @return misspelled word
+	 */
+	string misspell(const string &word, int edits) {
+		string result = word;
+		for (int e = 0; e < edits; e++) {
+			int kind = randomBelow(EDIT_KINDS);
+			if (result.length() < 2 && (kind == EDIT_DELETE || kind == EDIT_TRANSPOSE))
+				kind = EDIT_INSERT;
+
+			if (kind == EDIT_INSERT)
+				result.insert(result.begin() + randomBelow(result.length() + 1), randomLetter());
+
+			else if (kind == EDIT_DELETE)
+				result.erase(randomBelow(result.length()), 1);
+
+			else if (kind == EDIT_SUBSTITUTE && !result.empty()) {
+				int i = randomBelow(result.length());
+				char letter = randomLetter();
+				while (letter == result[i])
+					letter = randomLetter();
+				result[i] = letter;
+			}
+
+			else if (kind == EDIT_TRANSPOSE) {
+				int i = randomBelow(result.length() - 1);
+				std::swap(result[i], result[i + 1]);
+			}
+		}
+
+		return result;
+	}
+
+	/*
+	 * Picks count random dictionary words and misspells each with 1 to maxEdits edits. A
+	 * misspelling that is empty or that isWord accepts is redrawn from the same word
+	 * @param dictionary words, number of misspellings, max edits per word, predicate for dictionary words, output misspellings and their source words
+	 */
+	template <typename IsWord>
+	void generate(const vector<string> &words, int count, int maxEdits, IsWord isWord, vector<string> &misspellings, vector<string> &sources) {
+		for (int n = 0; n < count; n++) {
+			const string &word = words[randomBelow(words.size())];
+			int edits = 1 + randomBelow(maxEdits);
+			for (int attempt = 0; attempt < MISSPELLING_ATTEMPTS; attempt++) {
+				string misspelling = misspell(word, edits);
+				if (!misspelling.empty() && !isWord(misspelling)) {
+					misspellings.push_back(misspelling);
+					sources.push_back(word);
+					break;
+				}
+			}
+		}
+	}
+
+private:
+	/*
+	 * Returns a random number in 0...bound - 1
+	 * @param bound, which must be positive
+	 * @return random number
+	 */
+	int randomBelow(size_t bound) { return (int)(mRandom() % bound); }
+
+	/*
+	 * Returns a random lowercase letter
+	 * @return letter
+	 */
+	char randomLetter() { return MISSPELLING_ALPHABET[randomBelow(sizeof(MISSPELLING_ALPHABET) - 1)]; }
+
+	std::mt19937 mRandom;
+};
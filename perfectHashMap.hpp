@@ -0,0 +1,345 @@
+/*
+ * Alex Li
+ * perfectHashMap header
+ */
+
+#pragma once
+#include "hashMap.hpp"
+#include "hashPolicy.h"
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using std::string;
+using std::string_view;
+
+#define PERFECT_BUCKET_SIZE 5 // average keys per pilot bucket, trades build time for metadata bits
+#define PERFECT_DENSE_KEYS .6 // share of the keys hashed into the dense buckets
+#define PERFECT_DENSE_BUCKETS .3 // share of the buckets that are dense
+#define PERFECT_TABLE_LOAD .99 // keys / positions searched by the pilots, slack is remapped afterwards
+#define PERFECT_MAX_PILOT (1 << 20) // pilots tried per bucket before the build retries with another seed
+#define PERFECT_MAX_SEEDS 16 // seeds tried before the build gives up
+
+/*
+ * Array of unsigned values bit packed at the width of the largest one
+ */
+class PackedArray {
+public:
+	/*
+	 * Default PackedArray constructor, holds nothing
+	 */
+	PackedArray() : mBits(0) {}
+
+	/*
+	 * Replaces the contents with values, packed at the width of the largest
+	 * @param values
+	 */
+	void packedAssign(const std::vector<unsigned long long> &values) {
+		unsigned long long largest = 0;
+		for (size_t i = 0; i < values.size(); i++)
+			largest |= values[i];
+
+		mBits = 0;
+		while (mBits < 64 && (largest >> mBits) != 0)
+			mBits++;
+
+		mWords.assign(mBits ? (values.size() * mBits + 63) / 64 + 1 : 0, 0);
+		for (size_t i = 0; i < values.size() && mBits > 0; i++) {
+			size_t bit = i * mBits;
+			mWords[bit / 64] |= values[i] << (bit % 64);
+			if (bit % 64 + mBits > 64)
+				mWords[bit / 64 + 1] |= values[i] >> (64 - bit % 64);
+		}
+	}
+
+	/*
+	 * Returns one value
+	 * @param index
+	 * @return value
+	 */
+	unsigned long long packedAt(size_t index) const {
+		if (mBits == 0)
+			return 0;
+
+		size_t bit = index * mBits;
+		unsigned long long value = mWords[bit / 64] >> (bit % 64);
+		if (bit % 64 + mBits > 64)
+			value |= mWords[bit / 64 + 1] << (64 - bit % 64);
+		return mBits == 64 ? value : value & ((1ULL << mBits) - 1);
+	}
+
+	/*
+	 * Returns the bits held
+	 * @return bits of storage
+	 */
+	size_t packedBits() const { return mWords.size() * 64; }
+
+private:
+	std::vector<unsigned long long> mWords;
+	int mBits; // width of every value
+};
+
+/*
+ * Read only map built once from a HashMap with a minimal perfect hash in the style of
+ * PTHash. Keys are spread over n / PERFECT_BUCKET_SIZE buckets; each bucket stores a pilot,
+ * the first value whose mix with its keys' hashes sends every key of the bucket to a free
+ * position of a table slightly larger than n. Positions past n are remapped to the slots
+ * the pilots left free, so the n slots are all used. A lookup hashes the key, reads one
+ * pilot and compares one slot: no chains and no probing. As in PTHash, most keys go to a
+ * minority of dense buckets, which are placed first, while the table is nearly empty, so
+ * pilots stay small. Dense and sparse pilots are bit packed apart, each at the width of
+ * its largest, which comes to about 2.7 bits of metadata per key. The map trades lookup
+ * speed for memory: unpacking a pilot and remapping costs more than walking a short chain,
+ * and every miss compares a key where a chained miss often finds an empty bucket, so both
+ * hits and misses are slower than in the arena HashMap, for about 2 MB less besides keys
+ * on dictionary.txt
+ */
+template <typename K, typename V, typename Hash = WyHash>
+class PerfectHashMap {
+public:
+	/*
+	 * Builds the map from every link of a HashMap, finishing any incremental resize first.
+	 * The map is empty if no seed gives a perfect hash (see perfectBuilt)
+	 * @param map to freeze
+	 */
+	template <typename Alloc>
+	PerfectHashMap(HashMap<K, V, Hash, Alloc> &map) : mSeed(0), mBuckets(0), mDenseBuckets(0), mPositions(0), mBuilt(false) {
+		map.mapFinishResize();
+		for (int i = 0; i < map.mapCapacity(); i++) {
+			for (HashLink<K, V> *link = map.mapTableLink(i); link != nullptr; link = link->getNext())
+				mSlots.push_back(Slot { link->getKey(), link->getValue() });
+		}
+
+		for (unsigned long long seed = 0; seed < PERFECT_MAX_SEEDS && !mBuilt; seed++)
+			mBuilt = buildPilots(seed);
+
+		if (!mBuilt)
+			mSlots.clear();
+	}
+
+	/*
+	 * Returns whether a perfect hash was found for the keys
+	 * @return bool indicating whether the map holds the keys
+	 */
+	bool perfectBuilt() const { return mBuilt; }
+
+	/*
+	 * Returns a pointer to the value stored with the given key, or nullptr. The key may be
+	 * of any type the hash policy and K::compare accept, such as string_view for string keys
+	 * @param key
+	 * @return value or nullptr
+	 */
+	template <typename Key>
+	const V* mapGet(const Key &key) const { return mapGet(key, mHash(key)); }
+
+	/*
+	 * mapGet for a key whose policy hash the caller already has
+	 * @param key, Hash of key
+	 * @return value or nullptr
+	 */
+	template <typename Key>
+	const V* mapGet(const Key &key, unsigned long long hash) const {
+		if (mSlots.empty())
+			return nullptr;
+
+		const Slot &slot = mSlots[slotIndex(hash)];
+		return slot.key.compare(key) == 0 ? &slot.value : nullptr;
+	}
+
+	/*
+	 * Returns whether key is in the map, with one pilot read and one key comparison
+	 * @param key
+	 * @return bool indicating whether key exists in the map
+	 */
+	template <typename Key>
+	bool mapContains(const Key &key) const { return mapGet(key) != nullptr; }
+
+	/*
+	 * mapContains for a key whose policy hash the caller already has
+	 * @param key, Hash of key
+	 * @return bool indicating whether key exists in the map
+	 */
+	template <typename Key>
+	bool mapContains(const Key &key, unsigned long long hash) const { return mapGet(key, hash) != nullptr; }
+
+	/*
+	 * Returns the number of keys
+	 * @return number of keys
+	 */
+	int mapSize() const { return (int)mSlots.size(); }
+
+	/*
+	 * Returns the bits of hash metadata, the packed pilots and the remapped positions
+	 * @return metadata bits
+	 */
+	size_t perfectMetadataBits() const { return mDensePilots.packedBits() + mSparsePilots.packedBits() + mRemap.packedBits(); }
+
+	/*
+	 * Returns the bytes of the slots and the metadata, not counting key buffers
+	 * @return map bytes
+	 */
+	size_t perfectBytes() const { return mSlots.size() * sizeof(Slot) + perfectMetadataBits() / 8; }
+
+	/*
+	 * Returns the seed the build settled on
+	 * @return seed
+	 */
+	unsigned long long perfectSeed() const { return mSeed; }
+
+private:
+	struct Slot {
+		K key;
+		V value;
+	};
+
+	/*
+	 * Finalizer of splitmix64, scrambles every bit of x into every bit of the result
+	 * @param x
+	 * @return mixed x
+	 */
+	static unsigned long long perfectMix(unsigned long long x) {
+		x ^= x >> 30;
+		x *= 0xbf58476d1ce4e5b9ULL;
+		x ^= x >> 27;
+		x *= 0x94d049bb133111ebULL;
+		return x ^ (x >> 31);
+	}
+
+	/*
+	 * Returns the pilot bucket of a key hash: the low half of the hash picks dense or sparse,
+	 * the high half a bucket of that kind
+	 * @param seeded key hash
+	 * @return bucket index, dense buckets first
+	 */
+	unsigned long long bucketOf(unsigned long long hash) const {
+		if ((hash & 0xffffffffULL) < (unsigned long long)(PERFECT_DENSE_KEYS * 4294967296.0))
+			return (hash >> 32) % mDenseBuckets;
+		return mDenseBuckets + (hash >> 32) % (mBuckets - mDenseBuckets);
+	}
+
+	/*
+	 * Returns the table position a pilot sends a key hash to
+	 * @param seeded key hash, pilot
+	 * @return position in 0...mPositions - 1
+	 */
+	unsigned long long positionOf(unsigned long long hash, unsigned long long pilot) const {
+		return perfectMix(hash ^ perfectMix(pilot + 0x9e3779b97f4a7c15ULL)) % mPositions;
+	}
+
+	/*
+	 * Returns the slot of a key from its policy hash
+	 * @param policy hash
+	 * @return slot index
+	 */
+	size_t slotIndex(unsigned long long policyHash) const {
+		unsigned long long hash = perfectMix(policyHash ^ mSeed);
+		unsigned long long position = positionOf(hash, pilotAt(bucketOf(hash)));
+		return position < mSlots.size() ? position : mRemap.packedAt(position - mSlots.size());
+	}
+
+	/*
+	 * Returns the pilot of a bucket
+	 * @param bucket index
+	 * @return pilot
+	 */
+	unsigned long long pilotAt(unsigned long long bucket) const {
+		return bucket < mDenseBuckets ? mDensePilots.packedAt(bucket) : mSparsePilots.packedAt(bucket - mDenseBuckets);
+	}
+
+	/*
+	 * Searches a pilot for every bucket, largest buckets first, then packs the pilots,
+	 * remaps the positions past the last slot and moves every slot into place
+	 * @param seed mixed into the key hashes
+	 * @return bool indicating whether every bucket found a pilot
+	 */
+	bool buildPilots(unsigned long long seed) {
+		size_t count = mSlots.size();
+		mSeed = seed;
+		mBuckets = count / PERFECT_BUCKET_SIZE + 2;
+		mDenseBuckets = (unsigned long long)(mBuckets * PERFECT_DENSE_BUCKETS) + 1;
+		mPositions = (unsigned long long)(count / PERFECT_TABLE_LOAD) + 1;
+
+		std::vector<unsigned long long> hashes(count);
+		std::vector<std::vector<int> > buckets(mBuckets);
+		for (size_t i = 0; i < count; i++) {
+			hashes[i] = perfectMix(mHash(mSlots[i].key) ^ seed);
+			buckets[bucketOf(hashes[i])].push_back((int)i);
+		}
+
+		// buckets by size, largest first, while positions are still mostly free. Empty
+		// buckets keep pilot 0
+		std::vector<int> order;
+		for (unsigned long long b = 0; b < mBuckets; b++) {
+			if (!buckets[b].empty())
+				order.push_back((int)b);
+		}
+		std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return buckets[a].size() > buckets[b].size(); });
+
+		std::vector<bool> taken(mPositions, false);
+		std::vector<unsigned long long> pilots(mBuckets, 0), positions(count);
+		std::vector<unsigned long long> trial;
+		for (size_t o = 0; o < order.size(); o++) {
+			const std::vector<int> &keys = buckets[order[o]];
+			unsigned long long pilot = 0;
+			for (; pilot < PERFECT_MAX_PILOT; pilot++) {
+				trial.clear();
+				bool fits = true;
+				for (size_t k = 0; k < keys.size() && fits; k++) {
+					unsigned long long position = positionOf(hashes[keys[k]], pilot);
+					fits = !taken[position];
+					for (size_t t = 0; t < trial.size() && fits; t++)
+						fits = trial[t] != position;
+					trial.push_back(position);
+				}
+				if (fits)
+					break;
+			}
+
+			// equal hashes within a bucket never separate, nor do pilots past the limit
+			if (pilot == PERFECT_MAX_PILOT)
+				return false;
+
+			for (size_t k = 0; k < keys.size(); k++) {
+				taken[trial[k]] = true;
+				positions[keys[k]] = trial[k];
+			}
+			pilots[order[o]] = pilot;
+		}
+
+		mDensePilots.packedAssign(std::vector<unsigned long long>(pilots.begin(), pilots.begin() + mDenseBuckets));
+		mSparsePilots.packedAssign(std::vector<unsigned long long>(pilots.begin() + mDenseBuckets, pilots.end()));
+
+		// positions past the last slot go to the slots no key took, in order
+		std::vector<unsigned long long> remap(mPositions - count, 0);
+		size_t freeSlot = 0;
+		for (unsigned long long p = count; p < mPositions; p++) {
+			if (!taken[p])
+				continue;
+			while (taken[freeSlot])
+				freeSlot++;
+			remap[p - count] = freeSlot++;
+		}
+		mRemap.packedAssign(remap);
+
+		std::vector<Slot> slots(count);
+		for (size_t i = 0; i < count; i++) {
+			unsigned long long position = positions[i];
+			slots[position < count ? position : remap[position - count]] = std::move(mSlots[i]);
+		}
+		mSlots.swap(slots);
+		return true;
+	}
+
+	Hash mHash;
+	std::vector<Slot> mSlots; // one per key, at its perfect hash
+	PackedArray mDensePilots; // pilots of the dense buckets
+	PackedArray mSparsePilots; // pilots of the other buckets
+	PackedArray mRemap; // slot of every position past the last slot
+	unsigned long long mSeed; // mixed into every key hash
+	unsigned long long mBuckets; // number of pilot buckets
+	unsigned long long mDenseBuckets; // buckets 0...mDenseBuckets - 1 are dense
+	unsigned long long mPositions; // positions the pilots choose from, at least the number of keys
+	bool mBuilt;
+};
@@ -0,0 +1,31 @@
+/*
+ * Alex Li
+ * processMemory header
+ */
+
+#pragma once
+#include <cstdio>
+#include <sys/resource.h>
+#include <unistd.h>
+
+/*
+ * Returns the resident set size of the process: the bytes of its memory currently held in
+ * RAM, including pages of memory mapped files that have been touched. Read from
+ * /proc/self/statm; where that is unavailable the peak resident size from getrusage() is
+ * returned instead
+ * @return resident bytes
+ */
+inline long long processResidentBytes() {
+	long long pages = 0, resident = 0;
+	FILE *statm = fopen("/proc/self/statm", "r");
+	if (statm) {
+		int read = fscanf(statm, "%lld %lld", &pages, &resident);
+		fclose(statm);
+		if (read == 2)
+			return resident * sysconf(_SC_PAGESIZE);
+	}
+
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return (long long)usage.ru_maxrss * 1024;
+}
@@ -4,124 +4,281 @@
  */
 
 #include "hashMap.hpp"
+#include "suggestions.hpp"
+#include "documentChecker.hpp"
+#include "batchChecker.hpp"
+#include "processMemory.hpp"
 #include <fstream>
 #include <ctime>
+#include <chrono>
+#include <cstdlib>
 
 using std::ifstream;
 using std::clock;
 using std::cin;
+using std::cerr;
+using std::vector;
 
 // prototypes
-int loadDictionary(string fname, HashMap<string, int> *map);
-int calcLD(string word1, string word2);
-void spellChecker(HashMap<string, int> *dictionary);
+void spellChecker(Dictionary *dictionary, SuggestOptions *options);
+int documentCheck(string fname, Dictionary *dictionary, SuggestOptions *options, int threads);
 
-int main() {
+int main(int argc, char *argv[]) {
 	double start, end, elapsed;
-	string dictionaryFile = "dictionary.txt";
-	HashMap<string, int> *dictionary = new HashMap<string, int> (1000);
+	string dictionaryName = "dictionary.txt";
+	bool checkMode = false;
+	bool statsMode = false; // print table stats after load and on exit
+	bool freezeMode = false; // answer lookups from a minimal perfect hash once loaded
+	double filterBits = 0; // bits per word of a Bloom filter in front of lookups, 0 for none
+	long long cacheEntries = 0; // entries of the suggestion cache, 0 without a limit
+	long long cacheBytes = 0; // estimated bytes of the suggestion cache, 0 without a limit
+	bool cacheMode = false; // remember the suggestions of recurring misspellings
+	string checkFile = ""; // document to check, empty for stdin
+	string imageName = ""; // image to compile the dictionary into, empty to run the checker
+	SuggestOptions options;
+	options.mode = SUGGEST_PARTITION;
+	options.distance = calcLDSuggestion;
+	options.partitions = nullptr;
+	options.symSpell = nullptr;
+	options.bkTree = nullptr;
+	options.dawg = nullptr;
+	options.pool = nullptr;
+	options.cache = nullptr;
+	int threads = 1;
 
-	cout << "Loading dictionary file..." << endl;
-	// load dictionary into hash map
-	start = clock();
-	int loadStatus = loadDictionary(dictionaryFile, dictionary);
-	end = clock();
-	elapsed = end - start;
-	elapsed /= CLOCKS_PER_SEC;
+	// command line options
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if (arg.compare("--distance=matrix") == 0)
+			options.distance = calcLD;
 
-	if (loadStatus == -1) {
-		cout << "Failed to load dictionary file!" << endl;
-		delete dictionary;
-		return 1;
-	}
+		else if (arg.compare("--distance=myers") == 0)
+			options.distance = calcLDMyers;
 
-	cout << "Dictionary loaded in " << elapsed << " seconds." << endl;
-	cout << "Dictionary contains " << dictionary->mapSize() << " entries hashed into " << dictionary->mapCapacity() << " buckets." << endl;
-	cout << "Table load: " << dictionary->mapTableLoad() << endl;
+		else if (arg.compare("--distance=bounded") == 0)
+			options.distance = calcLDSuggestion;
 
-	// run spellChecker with loaded dictionary
-	spellChecker(dictionary);
+		else if (arg.compare("--suggest=scan") == 0)
+			options.mode = SUGGEST_SCAN;
 
-	delete dictionary;
-	return 0;
-}
+		else if (arg.compare("--suggest=partition") == 0)
+			options.mode = SUGGEST_PARTITION;
 
-/********** function implementation **********/
-/*	 
-* Loads the dictionary.txt file into the hash table
-* Returns 0 on success and -1 otherwise
-* @param dictionary file name (dictionary.txt) and ptr to hash map
-* @return int indicating whether load was successful
-*/
-int loadDictionary(string fname, HashMap<string, int> *map) {
-	string inputbuffer = "";
-	ifstream dictionaryFile(fname);
-	if (dictionaryFile.is_open()) {
-		while (!dictionaryFile.eof()) {
-			getline(dictionaryFile, inputbuffer);
-			map->mapPut(inputbuffer, 1);
+		else if (arg.compare("--suggest=symspell") == 0)
+			options.mode = SUGGEST_SYMSPELL;
+
+		else if (arg.compare("--suggest=bktree") == 0)
+			options.mode = SUGGEST_BKTREE;
+
+		else if (arg.compare("--suggest=dawg") == 0)
+			options.mode = SUGGEST_DAWG;
+
+		else if (arg.compare(0, 10, "--threads=") == 0 && atoi(arg.c_str() + 10) > 0)
+			threads = atoi(arg.c_str() + 10);
+
+		else if (arg.compare("--check") == 0)
+			checkMode = true;
+
+		else if (arg.compare("--stats") == 0)
+			statsMode = true;
+
+		else if (arg.compare("--freeze") == 0)
+			freezeMode = true;
+
+		else if (arg.compare("--filter") == 0)
+			filterBits = BloomFilter::filterBitsForRate(FILTER_DEFAULT_RATE);
+
+		else if (arg.compare(0, 9, "--filter=") == 0 && atof(arg.c_str() + 9) > 0 && atof(arg.c_str() + 9) < 1)
+			filterBits = BloomFilter::filterBitsForRate(atof(arg.c_str() + 9));
+
+		else if (arg.compare(0, 14, "--filter-bits=") == 0 && atof(arg.c_str() + 14) > 0)
+			filterBits = atof(arg.c_str() + 14);
+
+		else if (arg.compare("--cache") == 0)
+			cacheMode = true;
+
+		else if (arg.compare(0, 8, "--cache=") == 0 && atoll(arg.c_str() + 8) > 0) {
+			cacheMode = true;
+			cacheEntries = atoll(arg.c_str() + 8);
+		}
+
+		else if (arg.compare(0, 14, "--cache-bytes=") == 0 && atoll(arg.c_str() + 14) > 0) {
+			cacheMode = true;
+			cacheBytes = atoll(arg.c_str() + 14);
+		}
+
+		else if (arg.compare(0, 8, "--check=") == 0) {
+			checkMode = true;
+			checkFile = arg.substr(8);
+		}
+
+		else if (arg.compare(0, 13, "--dictionary=") == 0 && arg.length() > 13)
+			dictionaryName = arg.substr(13);
+
+		else if (arg.compare("--compile-dictionary") == 0)
+			imageName = "dictionary.img";
+
+		else if (arg.compare(0, 21, "--compile-dictionary=") == 0 && arg.length() > 21)
+			imageName = arg.substr(21);
+
+		else {
+			cout << "Usage: " << argv[0] << " [--dictionary=file] [--distance=bounded|matrix|myers] [--suggest=partition|scan|symspell|bktree|dawg] [--threads=n] [--check[=file]] [--stats] [--freeze] [--filter[=rate]] [--filter-bits=n] [--cache[=entries]] [--cache-bytes=n] [--compile-dictionary[=file]]" << endl;
+			return 1;
 		}
-		dictionaryFile.close();	
-		return 0;
 	}
 
-	else
-		return -1;
-}
+	// a compiled image carries every index, so any mode can be served from it
+	bool compileMode = !imageName.empty();
+
+	if (options.mode == SUGGEST_PARTITION || compileMode)
+		options.partitions = new CandidateIndex();
+
+	if (options.mode == SUGGEST_SYMSPELL || compileMode)
+		options.symSpell = new SymSpellIndex(SUGGESTION_MAX_DISTANCE);
+
+	if (options.mode == SUGGEST_BKTREE || compileMode)
+		options.bkTree = new BKTree(calcLDMyers);
 
-int calcLD(string word1, string word2) {
-	int word1Len = word1.length();
-	int word2Len = word2.length();
+	if (options.mode == SUGGEST_DAWG || compileMode)
+		options.dawg = new Dawg();
 
-	if (word1Len == 0)
-		return word2Len;
+	// document checks spread whole words over their own pool, see documentCheck
+	if (threads > 1 && !checkMode)
+		options.pool = new ThreadPool(threads);
 
-	if (word2Len == 0)
-		return word1Len;
+	// a cache asked for without limits holds SUGGESTION_CACHE_DEFAULT_ENTRIES words
+	if (cacheMode && !compileMode)
+		options.cache = new SuggestionCache(cacheEntries || cacheBytes ? cacheEntries : SUGGESTION_CACHE_DEFAULT_ENTRIES, cacheBytes);
 
-	// construct matrix containing 0...word1Len + 1 rows and 0...word2Len + 1 columns
-	int matrix[word1Len + 1][word2Len + 1];
+	MappedFile dictionaryFile; // backs the dictionary keys, must outlive the dictionary
+	Dictionary *dictionary = new Dictionary(1000);
 
-	// initialize first column to 0...word1Len
-	for (int i = 0; i <= word1Len; i++)
-		matrix[i][0] = i;
+	// document check output owns stdout, so progress goes to stderr in that mode
+	std::ostream &status = checkMode ? cerr : cout;
 
-	// initialize first row to 0...word2Len
-	for (int i = 0; i <= word2Len; i++)
-		matrix[0][i] = i;
+	status << "Loading dictionary file..." << endl;
+	// load dictionary into hash map, on the suggestion pool or, in check mode, a pool of its own.
+	// The load is timed in wall time, since CPU time adds up across threads
+	ThreadPool *loadPool = options.pool ? options.pool : (threads > 1 ? new ThreadPool(threads) : nullptr);
+	std::chrono::steady_clock::time_point loadStart = std::chrono::steady_clock::now();
+	int loadStatus = loadDictionary(dictionaryName, dictionary, &dictionaryFile, loadPool);
+	elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - loadStart).count();
+	if (loadPool != options.pool)
+		delete loadPool;
 
-	// examine each character of word1
-	for (int i = 1; i <= word1Len; i++) {
-		char c1 = word1[i - 1];
+	if (loadStatus == -1) {
+		status << "Failed to load dictionary file!" << endl;
+		delete dictionary;
+		delete options.partitions;
+		delete options.symSpell;
+		delete options.bkTree;
+		delete options.dawg;
+		delete options.pool;
+		delete options.cache;
+		return 1;
+	}
+
+	status << "Dictionary loaded in " << elapsed << " seconds";
+	if (threads > 1 && !dictionary->dictionaryImage())
+		status << " on " << threads << " threads";
+	status << ", " << processResidentBytes() / 1024 << " KB resident";
+	if (dictionary->dictionaryImage())
+		status << " (image of " << dictionary->dictionaryImage()->imageBytes() << " bytes)";
+	status << "." << endl;
+	status << "Dictionary contains " << dictionary->mapSize() << " entries hashed into " << dictionary->mapCapacity() << " buckets." << endl;
+	status << "Table load: " << dictionary->mapTableLoad() << endl;
+	status << "Longest chain: " << dictionary->mapMaxChainLength() << " links, " << dictionary->mapEmptyBuckets() << " empty buckets" << endl;
+	if (statsMode)
+		printStats(status, dictionary->mapStats());
+
+	// an image is already read only and laid out for lookups, so only text dictionaries freeze
+	if (freezeMode && !dictionary->dictionaryImage()) {
+		start = clock();
+		int freezeStatus = dictionary->dictionaryFreeze();
+		end = clock();
+		elapsed = end - start;
+		elapsed /= CLOCKS_PER_SEC;
+
+		if (freezeStatus == -1)
+			status << "Failed to build a perfect hash, lookups stay on the table" << endl;
+		else
+			status << "Dictionary frozen in " << elapsed << " seconds, " << (double)dictionary->dictionaryFrozen()->perfectMetadataBits() / dictionary->mapSize() << " bits of hash metadata per word" << endl;
+	}
+
+	if (filterBits > 0) {
+		start = clock();
+		dictionary->dictionaryFilter(filterBits);
+		end = clock();
+		elapsed = end - start;
+		elapsed /= CLOCKS_PER_SEC;
 
-		// examine each character of word2
-		for (int j = 1; j <= word2Len; j++) {
-			char c2 = word2[j - 1];
+		const BloomFilter *filter = dictionary->dictionaryFilter();
+		status << "Bloom filter built in " << elapsed << " seconds, " << filter->filterBytes() << " bytes (" << filterBits << " bits per word, ";
+		status << filter->filterHashes() << " bits set per word, false positive rate near " << BloomFilter::filterRate(filterBits) << ")" << endl;
+	}
+
+	// build the suggestion index selected on the command line, each timed on its own
+	SuggestBuildTimes buildTimes;
+	buildSuggestionIndexes(dictionary, &options, &buildTimes);
+
+	if (options.partitions)
+		status << "Candidate index: " << options.partitions->indexSize() << " words in " << options.partitions->indexBytes() << " bytes, built in " << buildTimes.partitions << " seconds" << endl;
 
-			if (c1 == c2)
-				matrix[i][j] = matrix[i - 1][j - 1];
+	if (options.symSpell)
+		status << "SymSpell index: " << options.symSpell->indexSize() << " words, " << options.symSpell->indexEntries() << " deletion entries in " << options.symSpell->indexBytes() << " bytes, built in " << buildTimes.symSpell << " seconds" << endl;
 
-			else {
-				int deletion = matrix[i - 1][j] + 1;
-				int insert = matrix[i][j - 1] + 1;
-				int sub = matrix[i-1][j - 1] + 1;
-				
-				int min = deletion;
-				if (insert < min)
-					min = insert;
+	if (options.bkTree)
+		status << "BK-tree: " << options.bkTree->treeSize() << " nodes in " << options.bkTree->treeBytes() << " bytes, built in " << buildTimes.bkTree << " seconds" << endl;
 
-				if (sub < min)
-					min = sub;
+	if (options.dawg)
+		status << "DAWG: " << options.dawg->dawgSize() << " words in " << options.dawg->dawgStates() << " states and " << options.dawg->dawgEdges() << " edges, " << options.dawg->dawgBytes() << " bytes, built in " << buildTimes.dawg << " seconds" << endl;
 
-				matrix[i][j] = min;
-			}
+	// compile the dictionary, check a whole document, or run spellChecker with loaded dictionary
+	int exitStatus = 0;
+	if (compileMode) {
+		start = clock();
+		long long imageBytes = compileDictionary(imageName, dictionary, &options);
+		end = clock();
+		elapsed = end - start;
+		elapsed /= CLOCKS_PER_SEC;
+
+		if (imageBytes == -1) {
+			status << "Failed to write " << imageName << "!" << endl;
+			exitStatus = 1;
 		}
+		else
+			status << "Dictionary image: " << imageBytes << " bytes written to " << imageName << " in " << elapsed << " seconds" << endl;
 	}
+	else if (checkMode)
+		exitStatus = documentCheck(checkFile, dictionary, &options, threads) == -1 ? 1 : 0;
+	else
+		spellChecker(dictionary, &options);
 
-	return matrix[word1Len][word2Len];
+	if (statsMode) {
+		status << "Dictionary stats on exit:" << endl;
+		printStats(status, dictionary->mapStats());
+	}
+
+	if (options.cache)
+		printCacheStats(status, options.cache->cacheStats());
+
+	delete dictionary;
+	delete options.partitions;
+	delete options.symSpell;
+	delete options.bkTree;
+	delete options.dawg;
+	delete options.pool;
+	delete options.cache;
+	return exitStatus;
 }
 
-void spellChecker(HashMap<string, int> *dictionary) {
+/********** function implementation **********/
+/*
+ * Interactive spell check loop. Words missing from the dictionary get suggestions within
+ * edit distance 2, searched and measured as selected in options
+ * @param ptr to loaded dictionary and suggestion options
+ */
+void spellChecker(Dictionary *dictionary, SuggestOptions *options) {
 	string inputbuffer = "";
 	bool quit = false;
 
@@ -139,27 +296,54 @@ void spellChecker(HashMap<string, int> *dictionary) {
 
 		// print suggested words based on edit distance
 		else {
+			vector<string> suggestions;
+			collectSuggestions(dictionary, options, inputbuffer, suggestions);
+
 			cout << "\nDid you mean: " << endl;
-			for (int i = 0; i < dictionary->mapCapacity(); i++) {
-				HashLink<string, int> *seeker = dictionary->mapTableLink(i);
-				while (seeker) {
-					string seekerKey = seeker->getKey();
-					/* result filters:
-                     * the length of the suggestion is at least the length of the misspelled word
-                     * the first letter of the misspelled word is correct
-                     * levenshtein distance between words is 1 or 2
-                     */
-					if (seekerKey.length() >= inputbuffer.length() && seekerKey[0] == inputbuffer[0]) {
-						// calculate edit distance between mispelled word and filtered words
-						int LD = calcLD(inputbuffer, seeker->getKey());
-                    	if ((LD == 1 || LD == 2)) 
-                    		cout << seekerKey << endl;
-                	}
-
-                	seeker = seeker->getNext();
-				}
-			}
+			for (size_t i = 0; i < suggestions.size(); i++)
+				cout << suggestions[i] << endl;
+
+			if (options->mode == SUGGEST_BKTREE)
+				cout << "(BK-tree search visited " << options->bkTree->treeLastVisits() << " of " << options->bkTree->treeSize() << " nodes)" << endl;
 			cout << endl;
 		} 
 	}
 }
+
+/*
+ * Non-interactive mode. Streams a document from the file (or stdin when fname is empty)
+ * through checkDocument, or with more than one thread reads it whole and checks it with
+ * checkDocumentBatch on a work stealing pool, then reports the checking rate on stderr.
+ * The rate is measured in wall time, since CPU time adds up across threads
+ * Returns 0 on success and -1 if the file cannot be opened
+ * @param document file name or empty string, ptr to loaded dictionary and suggestion options, number of threads
+ * @return int indicating whether the document was checked
+ */
+int documentCheck(string fname, Dictionary *dictionary, SuggestOptions *options, int threads) {
+	std::ios::sync_with_stdio(false);
+
+	ifstream document;
+	if (!fname.empty()) {
+		document.open(fname, std::ios::binary);
+		if (!document.is_open()) {
+			cerr << "Failed to open " << fname << "!" << endl;
+			return -1;
+		}
+	}
+
+	std::istream &in = fname.empty() ? cin : document;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	CheckStats stats;
+	if (threads > 1) {
+		WorkStealingPool pool(threads);
+		stats = checkDocumentBatch(in, cout, dictionary, options, &pool);
+	}
+	else
+		stats = checkDocument(in, cout, dictionary, options);
+	cout.flush();
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	cerr << "Checked " << stats.words << " words (" << stats.misspellings << " misspelled) in " << elapsed << " seconds, ";
+	cerr << (elapsed > 0 ? stats.words / elapsed : 0) << " words per second" << endl;
+	return 0;
+}
@@ -0,0 +1,235 @@
+/*
+ * Alex Li
+ * suggestionCache header
+ */
+
+#pragma once
+#include "dictionary.hpp"
+#include "hashMap.hpp"
+#include "hashPolicy.h"
+#include <atomic>
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+#define SUGGESTION_CACHE_SHARD_BITS 4 // 16 shards
+#define SUGGESTION_CACHE_SHARDS (1 << SUGGESTION_CACHE_SHARD_BITS)
+#define SUGGESTION_CACHE_DEFAULT_ENTRIES 4096 // entries of a cache asked for without a size
+
+// snapshot returned by cacheStats()
+struct SuggestionCacheStats {
+	size_t entries = 0; // cached words
+	size_t bytes = 0; // estimated bytes of the cached words, suggestions and bookkeeping
+	unsigned long long hits = 0; // lookups answered from the cache
+	unsigned long long misses = 0; // lookups that had to search
+	unsigned long long evictions = 0; // least recently used entries dropped for room
+	unsigned long long invalidations = 0; // entries dropped because the dictionary changed
+};
+
+/*
+ * Bounded least recently used cache from misspelled word to its suggestion list, so a
+ * misspelling that recurs in a document is searched once. Words are split into
+ * SUGGESTION_CACHE_SHARDS shards by the top bits of their hash, each an LRU list and a
+ * HashMap index behind its own mutex, so threads only contend within a shard. The entry and
+ * byte limits, either 0 for none, are divided evenly among the shards, rounding up.
+ *
+ * Entries belong to one dictionary at one version. A shard that sees another dictionary or
+ * a changed Dictionary::dictionaryVersion() (a new word put, a word removed or a load)
+ * drops all of its entries first, so stale suggestions are never returned. The cache
+ * assumes the suggestion options do not change while it is in use
+ */
+class SuggestionCache {
+public:
+	/*
+	 * Parameterized SuggestionCache constructor
+	 * @param max entries, max estimated bytes, 0 for no limit
+	 */
+	SuggestionCache(size_t maxEntries, size_t maxBytes = 0) : mHits(0), mMisses(0), mEvictions(0), mInvalidations(0) {
+		mShardEntries = maxEntries ? (maxEntries + SUGGESTION_CACHE_SHARDS - 1) / SUGGESTION_CACHE_SHARDS : 0;
+		mShardBytes = maxBytes ? (maxBytes + SUGGESTION_CACHE_SHARDS - 1) / SUGGESTION_CACHE_SHARDS : 0;
+	}
+
+	SuggestionCache(const SuggestionCache &) = delete;
+	SuggestionCache &operator=(const SuggestionCache &) = delete;
+
+	/*
+	 * Appends the cached suggestions for word to suggestions and marks the entry most
+	 * recently used. Counts a hit or a miss
+	 * @param ptr to the dictionary searched, misspelled word, output suggestions
+	 * @return bool indicating whether word was cached
+	 */
+	bool cacheGet(const Dictionary *dictionary, const string &word, vector<string> &suggestions) {
+		Shard &shard = shardOf(word);
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		validate(shard, dictionary);
+
+		std::list<CacheEntry>::iterator *entry = shard.index.mapGet(string_view(word));
+		if (!entry) {
+			mMisses.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		shard.entries.splice(shard.entries.begin(), shard.entries, *entry);
+		suggestions.insert(suggestions.end(), (*entry)->suggestions.begin(), (*entry)->suggestions.end());
+		mHits.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	/*
+	 * Caches the suggestions for word as the most recently used entry, replacing any entry
+	 * for it, then evicts least recently used entries of its shard until the shard is within
+	 * its limits. An entry larger than the byte limit is not cached
+	 * @param ptr to the dictionary searched, misspelled word, its suggestions
+	 */
+	void cachePut(const Dictionary *dictionary, const string &word, const vector<string> &suggestions) {
+		Shard &shard = shardOf(word);
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		validate(shard, dictionary);
+
+		std::list<CacheEntry>::iterator *old = shard.index.mapGet(string_view(word));
+		if (old)
+			dropEntry(shard, *old);
+
+		CacheEntry entry = { word, suggestions, 0 };
+		entry.bytes = entryBytes(entry);
+		if (mShardBytes && entry.bytes > mShardBytes)
+			return;
+
+		shard.entries.push_front(std::move(entry));
+		shard.index.mapPut(string_view(shard.entries.front().word), shard.entries.begin());
+		shard.bytes += shard.entries.front().bytes;
+
+		while ((mShardEntries && shard.entries.size() > mShardEntries) || (mShardBytes && shard.bytes > mShardBytes)) {
+			dropEntry(shard, std::prev(shard.entries.end()));
+			mEvictions.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	/*
+	 * Drops every entry. The counters are kept
+	 */
+	void cacheClear() {
+		for (int i = 0; i < SUGGESTION_CACHE_SHARDS; i++) {
+			std::lock_guard<std::mutex> lock(mShards[i].mutex);
+			clearShard(mShards[i]);
+		}
+	}
+
+	/*
+	 * Returns the size and counters of the cache
+	 * @return stats snapshot
+	 */
+	SuggestionCacheStats cacheStats() const {
+		SuggestionCacheStats stats;
+		for (int i = 0; i < SUGGESTION_CACHE_SHARDS; i++) {
+			std::lock_guard<std::mutex> lock(mShards[i].mutex);
+			stats.entries += mShards[i].entries.size();
+			stats.bytes += mShards[i].bytes;
+		}
+
+		stats.hits = mHits;
+		stats.misses = mMisses;
+		stats.evictions = mEvictions;
+		stats.invalidations = mInvalidations;
+		return stats;
+	}
+
+private:
+	// one cached word, the key of the shard index points into it
+	struct CacheEntry {
+		string word;
+		vector<string> suggestions;
+		size_t bytes; // estimated, see entryBytes
+	};
+
+	// independently locked part of the cache, most recently used entry first
+	struct Shard {
+		Shard() : index(16), bytes(0), dictionary(nullptr), version(0) {}
+
+		mutable std::mutex mutex;
+		std::list<CacheEntry> entries;
+		HashMap<string_view, std::list<CacheEntry>::iterator> index;
+		size_t bytes;
+		const Dictionary *dictionary; // dictionary the entries were searched in
+		unsigned long long version; // its version then
+	};
+
+	/*
+	 * Returns the shard of a word, chosen by the top bits of its hash so the shard index
+	 * tables, which use the low bits, stay evenly filled
+	 * @param word
+	 * @return shard
+	 */
+	Shard& shardOf(const string &word) { return mShards[mHash(string_view(word)) >> (64 - SUGGESTION_CACHE_SHARD_BITS)]; }
+
+	/*
+	 * Drops the entries of a shard if they were searched in another dictionary or an earlier
+	 * version of it, then binds the shard to the current one. The shard must be locked
+	 * @param shard, ptr to the dictionary searched
+	 */
+	void validate(Shard &shard, const Dictionary *dictionary) {
+		if (shard.dictionary == dictionary && shard.version == dictionary->dictionaryVersion())
+			return;
+
+		mInvalidations.fetch_add(shard.entries.size(), std::memory_order_relaxed);
+		clearShard(shard);
+		shard.dictionary = dictionary;
+		shard.version = dictionary->dictionaryVersion();
+	}
+
+	/*
+	 * Removes one entry from a shard and its index. The shard must be locked
+	 * @param shard, entry
+	 */
+	static void dropEntry(Shard &shard, std::list<CacheEntry>::iterator entry) {
+		shard.index.mapRemove(string_view(entry->word));
+		shard.bytes -= entry->bytes;
+		shard.entries.erase(entry);
+	}
+
+	/*
+	 * Removes every entry of a shard. The shard must be locked
+	 * @param shard
+	 */
+	static void clearShard(Shard &shard) {
+		while (!shard.entries.empty())
+			dropEntry(shard, shard.entries.begin());
+	}
+
+	/*
+	 * Returns the estimated bytes an entry holds: its list node and index link, the word
+	 * and every suggestion
+	 * @param entry
+	 * @return estimated bytes
+	 */
+	static size_t entryBytes(const CacheEntry &entry) {
+		size_t bytes = sizeof(CacheEntry) + 2 * sizeof(void *) + sizeof(HashLink<string_view, std::list<CacheEntry>::iterator>);
+		bytes += entry.word.capacity() + entry.suggestions.capacity() * sizeof(string);
+		for (size_t i = 0; i < entry.suggestions.size(); i++)
+			bytes += entry.suggestions[i].capacity();
+		return bytes;
+	}
+
+	Shard mShards[SUGGESTION_CACHE_SHARDS];
+	size_t mShardEntries, mShardBytes; // limits of each shard, 0 for none
+	WyHash mHash;
+	std::atomic<unsigned long long> mHits, mMisses, mEvictions, mInvalidations;
+};
+
+/*
+ * Prints the size and counters of a suggestion cache
+ * @param output stream, snapshot
+ */
+inline void printCacheStats(std::ostream &os, const SuggestionCacheStats &stats) {
+	unsigned long long lookups = stats.hits + stats.misses;
+	os << "Suggestion cache: " << stats.entries << " entries in about " << stats.bytes << " bytes, " << stats.hits << " hits of " << lookups << " lookups (";
+	os << (lookups ? 100.0 * stats.hits / lookups : 0) << "%), " << stats.evictions << " evictions, " << stats.invalidations << " invalidated" << std::endl;
+}
@@ -0,0 +1,368 @@
+/*
+ * Alex Li
+ * suggestions header
+ */
+
+#pragma once
+#include "dictionary.hpp"
+#include "editDistance.hpp"
+#include "candidateIndex.hpp"
+#include "symSpellIndex.hpp"
+#include "bkTree.hpp"
+#include "dawg.hpp"
+#include "suggestionCache.hpp"
+#include "threadPool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+#define SUGGESTION_CHUNKS_PER_THREAD 4
+
+// where suggestions for a misspelled word are searched
+enum SuggestMode {
+	SUGGEST_SCAN, // every link of every bucket (reference)
+	SUGGEST_PARTITION, // CandidateIndex partitions that can pass the filters
+	SUGGEST_SYMSPELL, // SymSpellIndex deletion variant lookups
+	SUGGEST_BKTREE, // BKTree metric search
+	SUGGEST_DAWG // Dawg intersected with the Levenshtein automaton of the word
+};
+
+// suggestion search configuration chosen on the command line
+struct SuggestOptions {
+	SuggestMode mode;
+	DistanceFunction distance;
+	CandidateIndex *partitions;
+	SymSpellIndex *symSpell;
+	BKTree *bkTree;
+	Dawg *dawg;
+	ThreadPool *pool; // splits scan and partition searches across threads, nullptr for serial
+	SuggestionCache *cache; // remembers the suggestions of recurring misspellings, nullptr for none
+};
+
+// seconds each suggestion index took to build or read from an image, see buildSuggestionIndexes
+struct SuggestBuildTimes {
+	double partitions = 0;
+	double symSpell = 0;
+	double bkTree = 0;
+	double dawg = 0;
+};
+
+/*
+ * Collects suggestions for word by walking every link of the buckets first...last - 1
+ * @param ptr to loaded dictionary, misspelled word, distance kernel, bucket range and output suggestions
+ */
+inline void suggestScanRange(Dictionary *dictionary, const string &word, DistanceFunction distance, int first, int last, vector<string> &suggestions) {
+	dictionary->mapVisitKeys(first, last, [&](string_view seekerKey) {
+		/* result filters:
+		 * the length of the suggestion is at least the length of the misspelled word
+		 * the first letter of the misspelled word is correct
+		 * levenshtein distance between words is 1 to SUGGESTION_MAX_DISTANCE (2)
+		 */
+		if (seekerKey.length() >= word.length() && seekerKey[0] == word[0]) {
+			// calculate edit distance between mispelled word and filtered words
+			int LD = distance(word, seekerKey);
+			if (LD >= 1 && LD <= SUGGESTION_MAX_DISTANCE)
+				suggestions.push_back(string(seekerKey));
+		}
+	});
+}
+
+/*
+ * Collects suggestions for word by walking every link of every bucket in the table.
+ * Kept as the reference mode for benchmarks
+ * @param ptr to loaded dictionary, misspelled word, distance kernel and output suggestions
+ */
+inline void suggestScan(Dictionary *dictionary, const string &word, DistanceFunction distance, vector<string> &suggestions) {
+	suggestScanRange(dictionary, word, distance, 0, dictionary->mapCapacity(), suggestions);
+}
+
+/*
+ * Returns the number of candidate index records that suggestions for word are searched in
+ * @param ptr to candidate index, misspelled word
+ * @return number of candidates
+ */
+inline int partitionedCandidates(CandidateIndex *partitions, const string &word) {
+	int total = 0;
+	for (int length = word.length(); length <= (int)word.length() + SUGGESTION_MAX_DISTANCE; length++)
+		total += partitions->indexPartitionSize(word[0], length);
+
+	return total;
+}
+
+/*
+ * Collects suggestions for word from candidates first...last - 1 of the candidate index,
+ * numbering the records of the searched partitions consecutively in order of length
+ * @param ptr to candidate index, misspelled word, distance kernel, candidate range and output suggestions
+ */
+inline void suggestPartitionedRange(CandidateIndex *partitions, const string &word, DistanceFunction distance, int first, int last, vector<string> &suggestions) {
+	int base = 0; // number of the current partition's first record
+	for (int length = word.length(); length <= (int)word.length() + SUGGESTION_MAX_DISTANCE; length++) {
+		const char *records = partitions->indexPartition(word[0], length);
+		int count = partitions->indexPartitionSize(word[0], length);
+		int begin = first - base > 0 ? first - base : 0;
+		int end = last - base < count ? last - base : count;
+
+		for (int i = begin; i < end; i++) {
+			string_view candidate(records + i * length, length);
+			int LD = distance(word, candidate);
+			if (LD >= 1 && LD <= SUGGESTION_MAX_DISTANCE)
+				suggestions.push_back(string(candidate));
+		}
+		base += count;
+	}
+}
+
+/*
+ * Collects suggestions for word from the candidate index. Only the partitions starting with
+ * the same letter and up to SUGGESTION_MAX_DISTANCE characters longer than the word can
+ * pass the scan filters, so no other words are visited
+ * @param ptr to candidate index, misspelled word, distance kernel and output suggestions
+ */
+inline void suggestPartitioned(CandidateIndex *partitions, const string &word, DistanceFunction distance, vector<string> &suggestions) {
+	suggestPartitionedRange(partitions, word, distance, 0, partitionedCandidates(partitions, word), suggestions);
+}
+
+/*
+ * Splits the range 0...total - 1 into SUGGESTION_CHUNKS_PER_THREAD contiguous chunks per
+ * pool thread and runs search(first, last, results) for each chunk on the pool. Chunk
+ * results are appended in chunk order, so the suggestions come out exactly as a serial
+ * search of the whole range would produce them
+ * @param thread pool, size of range, ranged search and output suggestions
+ */
+template <typename RangeSearch>
+inline void suggestParallel(ThreadPool *pool, int total, RangeSearch search, vector<string> &suggestions) {
+	int chunks = pool->poolThreads() * SUGGESTION_CHUNKS_PER_THREAD;
+	vector<vector<string> > results(chunks);
+
+	pool->poolFor(chunks, [&](int chunk) {
+		search((int)((long long)total * chunk / chunks), (int)((long long)total * (chunk + 1) / chunks), results[chunk]);
+	});
+
+	for (int chunk = 0; chunk < chunks; chunk++)
+		suggestions.insert(suggestions.end(), results[chunk].begin(), results[chunk].end());
+}
+
+/*
+ * Collects suggestions for word from the symmetric delete index. Candidates sharing a
+ * deletion variant with word are filtered and verified with the distance kernel
+ * @param ptr to symmetric delete index, misspelled word, distance kernel and output suggestions
+ */
+inline void suggestSymSpell(SymSpellIndex *symSpell, const string &word, DistanceFunction distance, vector<string> &suggestions) {
+	vector<int> ids;
+	symSpell->indexCandidates(word, ids);
+
+	for (size_t i = 0; i < ids.size(); i++) {
+		const string &candidate = symSpell->indexWord(ids[i]);
+		if (candidate.length() >= word.length() && candidate[0] == word[0]) {
+			int LD = distance(word, candidate);
+			if (LD >= 1 && LD <= SUGGESTION_MAX_DISTANCE)
+				suggestions.push_back(candidate);
+		}
+	}
+}
+
+/*
+ * Collects suggestions for word with a radius SUGGESTION_MAX_DISTANCE search of the BK-tree.
+ * The tree's own metric replaces the distance kernel, only the scan filters are applied
+ * @param ptr to BK-tree, misspelled word and output suggestions
+ */
+inline void suggestBKTree(BKTree *bkTree, const string &word, vector<string> &suggestions) {
+	vector<int> ids;
+	bkTree->treeSearch(word, SUGGESTION_MAX_DISTANCE, ids);
+
+	for (size_t i = 0; i < ids.size(); i++) {
+		string_view candidate = bkTree->treeWord(ids[i]);
+		if (candidate.length() >= word.length() && candidate[0] == word[0] && candidate.compare(word) != 0)
+			suggestions.push_back(string(candidate));
+	}
+}
+
+/*
+ * Collects suggestions for word by intersecting the DAWG with the word's Levenshtein
+ * automaton. The first letter is fixed during the walk, so only one subtree of the root is
+ * searched; the remaining scan filters are applied to the results
+ * @param ptr to DAWG, misspelled word and output suggestions
+ */
+inline void suggestDawg(Dawg *dawg, const string &word, vector<string> &suggestions) {
+	vector<string> matches;
+	dawg->dawgSearch(word, SUGGESTION_MAX_DISTANCE, 1, matches);
+
+	for (size_t i = 0; i < matches.size(); i++) {
+		if (matches[i].length() >= word.length() && matches[i].compare(word) != 0)
+			suggestions.push_back(matches[i]);
+	}
+}
+
+/*
+ * Builds the suggestion indexes allocated in options from the keys of the loaded dictionary.
+ * Indexes stored in an attached dictionary image are read from it instead of rebuilt. Each
+ * index is built in a pass of its own over the keys, so its time can be reported apart
+ * @param ptr to loaded dictionary, suggestion options, output build times or nullptr
+ */
+inline void buildSuggestionIndexes(Dictionary *dictionary, SuggestOptions *options, SuggestBuildTimes *times = nullptr) {
+	typedef std::chrono::steady_clock buildClock;
+	auto secondsSince = [](buildClock::time_point start) { return std::chrono::duration<double>(buildClock::now() - start).count(); };
+
+	CandidateIndex *partitions = options->partitions;
+	SymSpellIndex *symSpell = options->symSpell;
+	BKTree *bkTree = options->bkTree;
+	Dawg *dawg = options->dawg;
+	SuggestBuildTimes spent;
+
+	const DictionaryImage *image = dictionary->dictionaryImage();
+	if (image) {
+		ImageReader section;
+		buildClock::time_point start = buildClock::now();
+		if (partitions && image->imageSection(IMAGE_PARTITIONS, section) && partitions->indexLoad(section))
+			partitions = nullptr;
+		spent.partitions = secondsSince(start);
+
+		start = buildClock::now();
+		if (symSpell && image->imageSection(IMAGE_SYMSPELL, section) && symSpell->indexLoad(section))
+			symSpell = nullptr;
+		spent.symSpell = secondsSince(start);
+
+		start = buildClock::now();
+		if (bkTree && image->imageSection(IMAGE_BKTREE, section) && bkTree->treeLoad(section))
+			bkTree = nullptr;
+		spent.bkTree = secondsSince(start);
+
+		start = buildClock::now();
+		if (dawg && image->imageSection(IMAGE_DAWG, section) && dawg->dawgLoad(section))
+			dawg = nullptr;
+		spent.dawg = secondsSince(start);
+	}
+
+	if (partitions) {
+		buildClock::time_point start = buildClock::now();
+		dictionary->mapVisitKeys(0, dictionary->mapCapacity(), [&](string_view seekerKey) { partitions->indexAdd(string(seekerKey)); });
+		spent.partitions += secondsSince(start);
+	}
+
+	if (symSpell) {
+		buildClock::time_point start = buildClock::now();
+		dictionary->mapVisitKeys(0, dictionary->mapCapacity(), [&](string_view seekerKey) { symSpell->indexAdd(string(seekerKey)); });
+		symSpell->indexBuild();
+		spent.symSpell += secondsSince(start);
+	}
+
+	if (bkTree) {
+		buildClock::time_point start = buildClock::now();
+		dictionary->mapVisitKeys(0, dictionary->mapCapacity(), [&](string_view seekerKey) { bkTree->treeAdd(string(seekerKey)); });
+		bkTree->treeBuild();
+		spent.bkTree += secondsSince(start);
+	}
+
+	if (dawg) {
+		// the DAWG takes its keys in ascending order
+		buildClock::time_point start = buildClock::now();
+		vector<string> sorted;
+		dictionary->mapVisitKeys(0, dictionary->mapCapacity(), [&](string_view seekerKey) { sorted.push_back(string(seekerKey)); });
+		std::sort(sorted.begin(), sorted.end());
+		for (size_t i = 0; i < sorted.size(); i++)
+			dawg->dawgAdd(sorted[i]);
+		dawg->dawgBuild();
+		spent.dawg += secondsSince(start);
+	}
+
+	if (times)
+		*times = spent;
+}
+
+/*
+ * Writes the loaded dictionary and the built suggestion indexes allocated in options to a
+ * dictionary image file, which loadDictionary() attaches in place of the word list
+ * Returns the size of the image in bytes, or -1 if the file cannot be written
+ * @param image file name, ptr to loaded dictionary and suggestion options
+ * @return image size or -1
+ */
+inline long long compileDictionary(const string &fname, Dictionary *dictionary, SuggestOptions *options) {
+	ImageWriter out;
+	imageStart(out);
+	dictionary->dictionaryWrite(out);
+
+	if (options->partitions) {
+		imageStartSection(out, IMAGE_PARTITIONS);
+		options->partitions->indexSave(out);
+	}
+
+	if (options->symSpell) {
+		imageStartSection(out, IMAGE_SYMSPELL);
+		options->symSpell->indexSave(out);
+	}
+
+	if (options->bkTree) {
+		imageStartSection(out, IMAGE_BKTREE);
+		options->bkTree->treeSave(out);
+	}
+
+	if (options->dawg) {
+		imageStartSection(out, IMAGE_DAWG);
+		options->dawg->dawgSave(out);
+	}
+
+	imageFinish(out);
+
+	std::ofstream imageFile(fname, std::ios::binary | std::ios::trunc);
+	if (!imageFile.is_open())
+		return -1;
+
+	imageFile.write(out.writerBytes().data(), out.writerBytes().size());
+	imageFile.close();
+	if (imageFile.fail())
+		return -1;
+
+	return (long long)out.writerBytes().size();
+}
+
+/*
+ * Collects suggestions for word from options->cache when it holds them, and otherwise from
+ * the source selected in options, caching the result. Scan and partition searches run on
+ * options->pool when one is set
+ * @param ptr to loaded dictionary, suggestion options, misspelled word and output suggestions
+ */
+inline void collectSuggestions(Dictionary *dictionary, SuggestOptions *options, const string &word, vector<string> &suggestions) {
+	if (options->cache && options->cache->cacheGet(dictionary, word, suggestions))
+		return;
+
+	if (options->cache) {
+		vector<string> searched;
+		SuggestOptions uncached = *options;
+		uncached.cache = nullptr;
+		collectSuggestions(dictionary, &uncached, word, searched);
+		options->cache->cachePut(dictionary, word, searched);
+		suggestions.insert(suggestions.end(), searched.begin(), searched.end());
+		return;
+	}
+
+	DistanceFunction distance = options->distance;
+
+	if (options->mode == SUGGEST_PARTITION && options->pool) {
+		CandidateIndex *partitions = options->partitions;
+		suggestParallel(options->pool, partitionedCandidates(partitions, word), [&](int first, int last, vector<string> &results) {
+			suggestPartitionedRange(partitions, word, distance, first, last, results);
+		}, suggestions);
+	}
+	else if (options->mode == SUGGEST_PARTITION)
+		suggestPartitioned(options->partitions, word, distance, suggestions);
+	else if (options->mode == SUGGEST_SYMSPELL)
+		suggestSymSpell(options->symSpell, word, distance, suggestions);
+	else if (options->mode == SUGGEST_BKTREE)
+		suggestBKTree(options->bkTree, word, suggestions);
+	else if (options->mode == SUGGEST_DAWG)
+		suggestDawg(options->dawg, word, suggestions);
+	else if (options->pool) {
+		suggestParallel(options->pool, dictionary->mapCapacity(), [&](int first, int last, vector<string> &results) {
+			suggestScanRange(dictionary, word, distance, first, last, results);
+		}, suggestions);
+	}
+	else
+		suggestScan(dictionary, word, distance, suggestions);
+}
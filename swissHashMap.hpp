@@ -0,0 +1,341 @@
+/*
+ * Alex Li
+ * swissHashMap header
+ */
+
+#pragma once
+#include "hashPolicy.h"
+#include <iostream>
+#include <string>
+#include <utility>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SWISS_GROUP_WIDTH 32
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SWISS_GROUP_WIDTH 16
+#else
+#define SWISS_GROUP_WIDTH 16
+#endif
+
+using std::cout;
+using std::endl;
+using std::string;
+
+#define SWISS_MAX_TABLE_LOAD .875
+#define SWISS_CTRL_EMPTY ((signed char)-128)
+#define SWISS_CTRL_DELETED ((signed char)-2)
+
+/*
+ * Open addressing table probed a whole group of slots at a time, after Abseil's SwissTable.
+ * Every slot has a control byte holding either EMPTY, DELETED or the low 7 bits of its
+ * key's hash. A lookup compares its fingerprint against a full group of control bytes with
+ * one SSE2 (16 slots) or AVX2 (32 slots) compare, and only calls compare() on keys whose
+ * fingerprint matched. Most misses therefore stop at the first group without reading any
+ * key. Exposes the same mapPut/mapContains/mapGet/mapRemove interface as HashMap.
+ */
+template <typename K, typename V, typename Hash = WyHash>
+class SwissHashMap {
+public:
+	/*
+	 * Parameterized SwissHashMap constructor. Capacity is rounded up to a power of two
+	 * number of groups
+	 * @param capacity
+	 */
+	SwissHashMap(int capacity) {
+		allocateTable(capacity);
+	}
+
+	/*
+	 * SwissHashMap destructor
+	 */
+	~SwissHashMap() {
+		delete[] mSlots;
+		delete[] mCtrl;
+	}
+
+	SwissHashMap(const SwissHashMap &) = delete;
+	SwissHashMap &operator=(const SwissHashMap &) = delete;
+
+	/*
+	 * Returns a pointer to the value stored with the given key. Returns nullptr if the key
+	 * is not in the table.
+	 * @param key
+	 * @return slot value or nullptr
+	 */
+	V* mapGet(const K &key) {
+		int index = findIndex(key);
+		if (index < 0)
+			return nullptr;
+
+		return &mSlots[index].value;
+	}
+
+	/*
+	 * Updates the value stored with the given key if it already exists in the table.
+	 * Otherwise stores the key-value pair in the first empty or deleted slot of its probe
+	 * sequence
+	 * @param key
+	 * @param value
+	 */
+	void mapPut(const K key, const V value) {
+		// update value if key exists in table
+		int index = findIndex(key);
+		if (index >= 0) {
+			mSlots[index].value = value;
+			return;
+		}
+
+		// grow once live entries pass half the max load, otherwise just flush tombstones
+		if (mSize + mDeleted + 1 > mCapacity * SWISS_MAX_TABLE_LOAD)
+			resizeTable(mapTableLoad() >= SWISS_MAX_TABLE_LOAD / 2 ? mCapacity * 2 : mCapacity);
+
+		insertSlot(key, value);
+	}
+
+	/*
+	 * Attemps to remove the key-value pair specified by the key parameter from the table.
+	 * The slot becomes EMPTY when its group still has an empty slot, since no probe
+	 * sequence can have continued past such a group; otherwise it is marked DELETED.
+	 * Returns true if removal was successful and false otherwise
+	 * @param key
+	 * @return bool indicating whether key-value pair removal was successful
+	 */
+	bool mapRemove(const K &key) {
+		int index = findIndex(key);
+		if (index < 0)
+			return false;
+
+		const signed char *group = mCtrl + (index & ~(SWISS_GROUP_WIDTH - 1));
+		if (matchByte(group, SWISS_CTRL_EMPTY) != 0)
+			mCtrl[index] = SWISS_CTRL_EMPTY;
+
+		else {
+			mCtrl[index] = SWISS_CTRL_DELETED;
+			mDeleted++;
+		}
+
+		mSlots[index] = Slot();
+		mSize--;
+		return true;
+	}
+
+	/*
+	 * Attemps to locate the key specified by the key parameter in the table.
+	 * Returns true if the key is found in the table and false otherwise
+	 * @param key
+	 * @return bool indicating whether key exists in table
+	 */
+	bool mapContains(const K &key) const { return findIndex(key) >= 0; }
+
+	/*
+	 * Returns the number of entries in the table
+	 * @return number of entries
+	 */
+	int mapSize() const { return mSize; }
+
+	/*
+	 * Returns number of slots in the table
+	 * @return number of slots
+	 */
+	int mapCapacity() const { return mCapacity; }
+
+	/*
+	 * Returns whether the slot specified by the index holds an entry
+	 * @return bool indicating whether slot is occupied
+	 */
+	bool mapSlotOccupied(int index) const { return mCtrl[index] >= 0; }
+
+	/*
+	 * Returns the key stored in the slot specified by the index. Only meaningful
+	 * when mapSlotOccupied(index) is true
+	 * @return key of specified slot
+	 */
+	const K& mapSlotKey(int index) const { return mSlots[index].key; }
+
+	/*
+	 * Returns the number of table slots without an entry, including deleted slots
+	 * @return number of empty slots
+	 */
+	int mapEmptyBuckets() const { return mCapacity - mSize; }
+
+	/*
+	 * Returns the ratio of (entries / slots) in the table currently
+	 * @return map table load
+	 */
+	double mapTableLoad() const {
+		double entries = (double)mapSize();
+		double slots = (double)mapCapacity();
+		return (entries / slots);
+	}
+
+	/*
+	 * Resizes the table to contain newCapacity number of slots (rounded up to a power of
+	 * two number of groups). Live entries are moved into the new table and tombstones are
+	 * dropped, then the old arrays are freed
+	 * @param new capacity (number of slots)
+	 */
+	void resizeTable(int newCapacity) {
+		Slot *oldSlots = mSlots;
+		signed char *oldCtrl = mCtrl;
+		int oldCapacity = mCapacity;
+
+		allocateTable(newCapacity);
+		for (int i = 0; i < oldCapacity; i++) {
+			if (oldCtrl[i] >= 0)
+				insertSlot(std::move(oldSlots[i].key), std::move(oldSlots[i].value));
+		}
+
+		delete[] oldSlots;
+		delete[] oldCtrl;
+	}
+
+	/*
+	 * Overload operator << for SwissHashMap print functionality
+	 * Prints the occupied slots in the format Slot n -> (key, value)
+	 * @param output stream os, SwissHashMap map
+	 * @returns output stream containing formatted SwissHashMap contents
+	 */
+	friend std::ostream& operator<<(std::ostream& os, const SwissHashMap<K, V, Hash>& map) {
+		for (int i = 0; i < map.mapCapacity(); i++) {
+			if (map.mapSlotOccupied(i))
+				os << "Slot " << i << " -> (" << map.mSlots[i].key << ", " << map.mSlots[i].value << ")" << endl;
+		}
+		os << endl;
+		return os;
+	}
+
+private:
+	struct Slot {
+		K key;
+		V value;
+	};
+
+	/*
+	 * Allocates empty slot and control arrays holding at least capacity slots
+	 * @param capacity
+	 */
+	void allocateTable(int capacity) {
+		mGroups = 1;
+		while (mGroups * SWISS_GROUP_WIDTH < capacity)
+			mGroups *= 2;
+
+		mCapacity = mGroups * SWISS_GROUP_WIDTH;
+		mSize = 0;
+		mDeleted = 0;
+		mSlots = new Slot[mCapacity]();
+		mCtrl = new signed char[mCapacity];
+		for (int i = 0; i < mCapacity; i++)
+			mCtrl[i] = SWISS_CTRL_EMPTY;
+	}
+
+	/*
+	 * Returns a bitmask with bit n set when control byte n of the group equals b
+	 * @return match mask
+	 */
+	static unsigned int matchByte(const signed char *group, signed char b) {
+#if defined(__AVX2__)
+		__m256i ctrl = _mm256_loadu_si256((const __m256i *)group);
+		return (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(ctrl, _mm256_set1_epi8(b)));
+#elif defined(__SSE2__)
+		__m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+		return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(b)));
+#else
+		unsigned int mask = 0;
+		for (int i = 0; i < SWISS_GROUP_WIDTH; i++) {
+			if (group[i] == b)
+				mask |= 1u << i;
+		}
+		return mask;
+#endif
+	}
+
+	/*
+	 * Returns a bitmask with bit n set when slot n of the group is EMPTY or DELETED.
+	 * Both markers are negative, so this is the sign bit of every control byte
+	 * @return free slot mask
+	 */
+	static unsigned int matchFree(const signed char *group) {
+#if defined(__AVX2__)
+		return (unsigned int)_mm256_movemask_epi8(_mm256_loadu_si256((const __m256i *)group));
+#elif defined(__SSE2__)
+		return (unsigned int)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)group));
+#else
+		unsigned int mask = 0;
+		for (int i = 0; i < SWISS_GROUP_WIDTH; i++) {
+			if (group[i] < 0)
+				mask |= 1u << i;
+		}
+		return mask;
+#endif
+	}
+
+	/*
+	 * Returns the slot index holding key, or -1 if it is not in the table. Groups are
+	 * visited in triangular order, which reaches every group of a power of two table,
+	 * and the search ends at the first group that still has an EMPTY slot
+	 * @return slot index or -1
+	 */
+	int findIndex(const K &key) const {
+		unsigned long long hash = mHash(key);
+		signed char fingerprint = (signed char)(hash & 0x7F);
+		int group = (int)((hash >> 7) & (mGroups - 1));
+
+		for (int probe = 1; probe <= mGroups; probe++) {
+			const signed char *ctrl = mCtrl + group * SWISS_GROUP_WIDTH;
+
+			unsigned int match = matchByte(ctrl, fingerprint);
+			while (match != 0) {
+				int index = group * SWISS_GROUP_WIDTH + __builtin_ctz(match);
+				if (mSlots[index].key.compare(key) == 0)
+					return index;
+
+				match &= match - 1;
+			}
+
+			if (matchByte(ctrl, SWISS_CTRL_EMPTY) != 0)
+				return -1;
+
+			group = (group + probe) & (mGroups - 1);
+		}
+
+		return -1;
+	}
+
+	/*
+	 * Stores a key known not to be in the table in the first EMPTY or DELETED slot of its
+	 * probe sequence. The caller guarantees there is room
+	 * @param key
+	 * @param value
+	 */
+	void insertSlot(K key, V value) {
+		unsigned long long hash = mHash(key);
+		int group = (int)((hash >> 7) & (mGroups - 1));
+
+		for (int probe = 1; ; probe++) {
+			unsigned int free = matchFree(mCtrl + group * SWISS_GROUP_WIDTH);
+			if (free != 0) {
+				int index = group * SWISS_GROUP_WIDTH + __builtin_ctz(free);
+				if (mCtrl[index] == SWISS_CTRL_DELETED)
+					mDeleted--;
+
+				mCtrl[index] = (signed char)(hash & 0x7F);
+				mSlots[index].key = std::move(key);
+				mSlots[index].value = std::move(value);
+				mSize++;
+				return;
+			}
+
+			group = (group + probe) & (mGroups - 1);
+		}
+	}
+
+	Hash mHash;
+	Slot* mSlots;
+	signed char* mCtrl; // control byte of each slot: EMPTY, DELETED or 7-bit fingerprint
+	int mSize; // number of entries in the table
+	int mDeleted; // number of DELETED control bytes
+	int mCapacity; // number of slots
+	int mGroups; // number of SWISS_GROUP_WIDTH slot groups
+};
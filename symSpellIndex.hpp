@@ -0,0 +1,205 @@
+/*
+ * Alex Li
+ * symSpellIndex header
+ */
+
+#pragma once
+#include "hashPolicy.h"
+#include "imageStream.hpp"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using std::string;
+
+/*
+ * Symmetric delete index (SymSpell). Every string obtainable by deleting up to maxDeletes
+ * characters from a dictionary word is hashed and recorded with the id of its source word.
+ * Two words within edit distance maxDeletes always share such a deletion variant, so the
+ * candidates for a query are found by hashing the query's own deletion variants and looking
+ * each one up, instead of scanning the dictionary. Entries are kept as one sorted array of
+ * 64-bit (32-bit variant hash, word id) pairs; hash collisions only add candidates, which
+ * the caller verifies with a distance kernel anyway.
+ */
+class SymSpellIndex {
+public:
+	/*
+	 * Parameterized SymSpellIndex constructor
+	 * @param maximum number of deletions per variant
+	 */
+	SymSpellIndex(int maxDeletes) : mMaxDeletes(maxDeletes), mMaxLength(0) {}
+
+	/*
+	 * Adds a word and all of its deletion variants to the index. indexBuild() must be
+	 * called after the last word is added and before querying
+	 * @param word
+	 */
+	void indexAdd(const string &word) {
+		int id = (int)mWords.size();
+		mWords.push_back(word);
+		if (word.length() > mMaxLength)
+			mMaxLength = word.length();
+
+		std::vector<string> variants;
+		deletionVariants(word, variants);
+		for (size_t i = 0; i < variants.size(); i++)
+			mEntries.push_back(makeEntry(mHash(variants[i]), id));
+	}
+
+	/*
+	 * Sorts the entries by variant hash so they can be binary searched
+	 */
+	void indexBuild() {
+		std::sort(mEntries.begin(), mEntries.end());
+		mEntries.shrink_to_fit();
+	}
+
+	/*
+	 * Collects the ids of every word sharing a deletion variant with word. Ids are
+	 * returned sorted and without duplicates. A word longer than the longest indexed word by
+	 * more than the deletion limit has no candidates, and its variants, which grow with the
+	 * square of its length, are never generated
+	 * @param word, output word ids
+	 */
+	void indexCandidates(const string &word, std::vector<int> &ids) const {
+		if (word.length() > mMaxLength + mMaxDeletes)
+			return;
+
+		std::vector<string> variants;
+		deletionVariants(word, variants);
+
+		for (size_t i = 0; i < variants.size(); i++) {
+			unsigned long long first = makeEntry(mHash(variants[i]), 0);
+			std::vector<unsigned long long>::const_iterator it = std::lower_bound(mEntries.begin(), mEntries.end(), first);
+			for (; it != mEntries.end() && (*it >> 32) == (first >> 32); ++it)
+				ids.push_back((int)(*it & 0xFFFFFFFF));
+		}
+
+		std::sort(ids.begin(), ids.end());
+		ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+	}
+
+	/*
+	 * Returns the word with the given id
+	 * @param word id
+	 * @return indexed word
+	 */
+	const string& indexWord(int id) const { return mWords[id]; }
+
+	/*
+	 * Returns the number of words in the index
+	 * @return number of words
+	 */
+	int indexSize() const { return (int)mWords.size(); }
+
+	/*
+	 * Returns the number of (variant hash, word id) entries in the index
+	 * @return number of entries
+	 */
+	size_t indexEntries() const { return mEntries.size(); }
+
+	/*
+	 * Returns the number of bytes held by the index, including its copies of the words
+	 * @return index size in bytes
+	 */
+	size_t indexBytes() const {
+		size_t bytes = mEntries.capacity() * sizeof(unsigned long long) + mWords.capacity() * sizeof(string);
+		for (size_t i = 0; i < mWords.size(); i++) {
+			if (mWords[i].capacity() > 15)
+				bytes += mWords[i].capacity() + 1;
+		}
+
+		return bytes;
+	}
+
+	/*
+	 * Writes the built index to a dictionary image: the deletion limit, the words as one
+	 * character pool with their lengths, and the sorted entries
+	 * @param image writer
+	 */
+	void indexSave(ImageWriter &out) const {
+		string pool;
+		std::vector<int> lengths;
+		for (size_t i = 0; i < mWords.size(); i++) {
+			pool.append(mWords[i]);
+			lengths.push_back((int)mWords[i].length());
+		}
+
+		out.writeValue(mMaxDeletes);
+		out.writeArray(pool.data(), pool.length());
+		out.writeArray(lengths.data(), lengths.size());
+		out.writeArray(mEntries.data(), mEntries.size());
+	}
+
+	/*
+	 * Replaces the index with one read from a dictionary image, already sorted, so
+	 * indexBuild() is not needed. The index is left unchanged if the image cannot be read
+	 * @param image reader
+	 * @return bool indicating whether the index was read
+	 */
+	bool indexLoad(ImageReader &in) {
+		int maxDeletes = 0;
+		string pool;
+		std::vector<int> lengths;
+		std::vector<unsigned long long> entries;
+		if (!in.readValue(maxDeletes) || !in.readString(pool) || !in.readVector(lengths) || !in.readVector(entries))
+			return false;
+
+		std::vector<string> words(lengths.size());
+		size_t offset = 0, maxLength = 0;
+		for (size_t i = 0; i < lengths.size(); i++) {
+			if (lengths[i] < 0 || (size_t)lengths[i] > pool.length() - offset)
+				return false;
+
+			words[i].assign(pool, offset, lengths[i]);
+			offset += lengths[i];
+			if ((size_t)lengths[i] > maxLength)
+				maxLength = lengths[i];
+		}
+
+		mMaxDeletes = maxDeletes;
+		mMaxLength = maxLength;
+		mWords.swap(words);
+		mEntries.swap(entries);
+		return true;
+	}
+
+private:
+	/*
+	 * Packs the upper half of a variant hash and a word id into one sortable entry
+	 * @return index entry
+	 */
+	static unsigned long long makeEntry(unsigned long long hash, int id) {
+		return (hash & 0xFFFFFFFF00000000ULL) | (unsigned int)id;
+	}
+
+	/*
+	 * Collects word and every distinct string reachable from it by deleting up to
+	 * mMaxDeletes characters
+	 * @param word, output variants
+	 */
+	void deletionVariants(const string &word, std::vector<string> &variants) const {
+		variants.push_back(word);
+		size_t begin = 0;
+
+		for (int d = 0; d < mMaxDeletes; d++) {
+			size_t end = variants.size();
+			for (size_t v = begin; v < end; v++) {
+				for (size_t i = 0; i < variants[v].length(); i++) {
+					string variant = variants[v];
+					variants.push_back(variant.erase(i, 1));
+				}
+			}
+			begin = end;
+		}
+
+		std::sort(variants.begin(), variants.end());
+		variants.erase(std::unique(variants.begin(), variants.end()), variants.end());
+	}
+
+	WyHash mHash;
+	std::vector<string> mWords; // source words by id
+	std::vector<unsigned long long> mEntries; // sorted by variant hash after indexBuild()
+	int mMaxDeletes; // maximum deletions per variant
+	size_t mMaxLength; // length of the longest indexed word
+};
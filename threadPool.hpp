@@ -0,0 +1,117 @@
+/*
+ * Alex Li
+ * threadPool header
+ */
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Fixed size pool of worker threads for data parallel loops. poolFor() hands out task
+ * indexes from a shared counter to the workers and the calling thread, and returns once
+ * every task has finished. A pool of one thread runs everything on the caller.
+ */
+class ThreadPool {
+public:
+	/*
+	 * Parameterized ThreadPool constructor. Starts threads - 1 workers, the thread calling
+	 * poolFor() is the last one
+	 * @param number of threads
+	 */
+	ThreadPool(int threads) : mThreads(threads < 1 ? 1 : threads), mGeneration(0), mTask(nullptr), mCount(0), mNext(0), mActive(0), mStop(false) {
+		for (int i = 1; i < mThreads; i++)
+			mWorkers.push_back(std::thread(&ThreadPool::workerLoop, this));
+	}
+
+	/*
+	 * ThreadPool destructor, stops and joins the workers
+	 */
+	~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mStop = true;
+		}
+		mWake.notify_all();
+
+		for (size_t i = 0; i < mWorkers.size(); i++)
+			mWorkers[i].join();
+	}
+
+	/*
+	 * Runs task(0) ... task(count - 1) across the pool and waits for all of them
+	 * @param number of tasks, task
+	 */
+	void poolFor(int count, const std::function<void(int)> &task) {
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mTask = &task;
+			mCount = count;
+			mNext = 0;
+			mActive = mThreads;
+			mGeneration++;
+		}
+		mWake.notify_all();
+
+		runTasks();
+
+		std::unique_lock<std::mutex> lock(mMutex);
+		mActive--;
+		mDone.wait(lock, [this] { return mActive == 0; });
+		mTask = nullptr;
+	}
+
+	/*
+	 * Returns the number of threads in the pool, including the caller
+	 * @return number of threads
+	 */
+	int poolThreads() const { return mThreads; }
+
+private:
+	/*
+	 * Claims and runs task indexes until the current loop is exhausted
+	 */
+	void runTasks() {
+		int index;
+		while ((index = mNext.fetch_add(1)) < mCount)
+			(*mTask)(index);
+	}
+
+	/*
+	 * Worker body: waits for a new loop, helps run it, reports completion
+	 */
+	void workerLoop() {
+		unsigned long long seen = 0;
+		while (true) {
+			{
+				std::unique_lock<std::mutex> lock(mMutex);
+				mWake.wait(lock, [this, seen] { return mStop || mGeneration != seen; });
+				if (mStop)
+					return;
+				seen = mGeneration;
+			}
+
+			runTasks();
+
+			std::lock_guard<std::mutex> lock(mMutex);
+			if (--mActive == 0)
+				mDone.notify_one();
+		}
+	}
+
+	int mThreads; // number of threads, including the caller
+	std::vector<std::thread> mWorkers;
+	std::mutex mMutex;
+	std::condition_variable mWake; // signals a new loop or shutdown
+	std::condition_variable mDone; // signals the last thread finished the loop
+	unsigned long long mGeneration; // number of loops started
+	const std::function<void(int)> *mTask; // body of the current loop
+	int mCount; // number of tasks in the current loop
+	std::atomic<int> mNext; // next unclaimed task index
+	int mActive; // threads still working on the current loop
+	bool mStop;
+};
@@ -0,0 +1,171 @@
+/*
+ * Alex Li
+ * workStealingPool header
+ */
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Thread pool for irregular task graphs. Every worker owns a deque of tasks: it pushes and
+ * pops its own work at the back (newest first, which keeps spawned subtasks cache warm) and,
+ * when its deque runs dry, steals the oldest task from the front of another worker's deque.
+ * A task may submit further tasks, which land on the submitting worker's own deque. Tasks
+ * submitted from outside the pool are dealt round robin.
+ */
+class WorkStealingPool {
+public:
+	typedef std::function<void()> Task;
+
+	/*
+	 * Parameterized WorkStealingPool constructor, starts the workers
+	 * @param number of worker threads
+	 */
+	WorkStealingPool(int threads) : mQueues(threads < 1 ? 1 : threads), mPending(0), mQueued(0), mSteals(0), mNextQueue(0), mStop(false) {
+		for (size_t i = 0; i < mQueues.size(); i++)
+			mWorkers.push_back(std::thread(&WorkStealingPool::workerLoop, this, (int)i));
+	}
+
+	/*
+	 * WorkStealingPool destructor, lets the workers drain their deques and joins them
+	 */
+	~WorkStealingPool() {
+		poolWait();
+		{
+			std::lock_guard<std::mutex> lock(mSleepMutex);
+			mStop = true;
+		}
+		mWake.notify_all();
+
+		for (size_t i = 0; i < mWorkers.size(); i++)
+			mWorkers[i].join();
+	}
+
+	/*
+	 * Queues a task. Called from a worker of this pool the task goes to that worker's deque,
+	 * otherwise to the next deque in round robin order
+	 * @param task
+	 */
+	void poolSubmit(Task task) {
+		int target = tPool == this ? tWorker : (int)(mNextQueue.fetch_add(1) % mQueues.size());
+		mPending++;
+		{
+			std::lock_guard<std::mutex> lock(mQueues[target].mutex);
+			mQueues[target].tasks.push_back(std::move(task));
+		}
+
+		mQueued++;
+		{
+			// pairs with the predicate check of a worker about to sleep
+			std::lock_guard<std::mutex> lock(mSleepMutex);
+		}
+		mWake.notify_one();
+	}
+
+	/*
+	 * Blocks until every submitted task, including tasks submitted by other tasks, has run
+	 */
+	void poolWait() {
+		std::unique_lock<std::mutex> lock(mSleepMutex);
+		mIdle.wait(lock, [this] { return mPending == 0; });
+	}
+
+	/*
+	 * Returns the number of worker threads
+	 * @return number of workers
+	 */
+	int poolThreads() const { return (int)mQueues.size(); }
+
+	/*
+	 * Returns the number of tasks taken from another worker's deque so far
+	 * @return number of steals
+	 */
+	long long poolSteals() const { return mSteals; }
+
+private:
+	struct Queue {
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	/*
+	 * Takes the newest task of worker's own deque, or else the oldest task of the first
+	 * other deque that has one
+	 * @param worker index, output task
+	 * @return bool indicating whether a task was taken
+	 */
+	bool takeTask(int worker, Task &task) {
+		int workers = (int)mQueues.size();
+		for (int k = 0; k < workers; k++) {
+			Queue &queue = mQueues[(worker + k) % workers];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (queue.tasks.empty())
+				continue;
+
+			if (k == 0) {
+				task = std::move(queue.tasks.back());
+				queue.tasks.pop_back();
+			}
+
+			else {
+				task = std::move(queue.tasks.front());
+				queue.tasks.pop_front();
+				mSteals++;
+			}
+
+			mQueued--;
+			return true;
+		}
+
+		return false;
+	}
+
+	/*
+	 * Worker body: runs tasks while any deque has one, sleeps otherwise
+	 * @param worker index
+	 */
+	void workerLoop(int worker) {
+		tPool = this;
+		tWorker = worker;
+
+		while (true) {
+			Task task;
+			if (takeTask(worker, task)) {
+				task();
+				if (--mPending == 0) {
+					std::lock_guard<std::mutex> lock(mSleepMutex);
+					mIdle.notify_all();
+				}
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(mSleepMutex);
+			mWake.wait(lock, [this] { return mStop || mQueued > 0; });
+			if (mStop && mQueued == 0)
+				return;
+		}
+	}
+
+	std::vector<Queue> mQueues; // one deque per worker
+	std::vector<std::thread> mWorkers;
+	std::mutex mSleepMutex;
+	std::condition_variable mWake; // signals queued work or shutdown
+	std::condition_variable mIdle; // signals that no task is pending
+	std::atomic<long long> mPending; // tasks submitted but not finished
+	std::atomic<long long> mQueued; // tasks sitting in a deque
+	std::atomic<long long> mSteals;
+	std::atomic<unsigned int> mNextQueue; // round robin target for outside submissions
+	bool mStop;
+
+	static thread_local WorkStealingPool *tPool; // pool of the current worker thread
+	static thread_local int tWorker; // index of the current worker thread
+};
+
+inline thread_local WorkStealingPool *WorkStealingPool::tPool = nullptr;
+inline thread_local int WorkStealingPool::tWorker = 0;